@@ -0,0 +1,156 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//*************************
+//class TN_AlignedAllocator
+//*************************
+//the default allocation policy of TN_Array. Memory is aligned to a 64-byte cache line,
+//and the fastest (nz) axis of an array is padded to a multiple of padcells cells.
+
+#ifndef TN_ALLOCATOR
+#define TN_ALLOCATOR
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(TN_INTERLEAVE) && defined(__linux__)
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+/*Number of cells the nz axis of every array is padded to a multiple of. Padding is counted
+in cells rather than bytes so that arrays of different datatypes, which appear together in
+expressions, share the same index space. 8 cells is one cache line of doubles.*/
+#ifndef TN_PADCELLS
+	#define TN_PADCELLS 1
+#endif
+
+/*With #define TN_INTERLEAVE, the pages of each allocation are interleaved across the NUMA
+nodes the process may use, rather than placed by first touch. This is only a placement hint,
+so it is silently skipped where the kernel does not support it.*/
+inline void TN_Interleave(void *p, size_t bytes){
+	#if defined(TN_INTERLEAVE) && defined(__linux__)
+		unsigned long nodes = 0;
+		int mode = 0;
+		const unsigned long maxnode = 8*sizeof(nodes);
+		//nodes allowed to this process (MPOL_F_MEMS_ALLOWED), then interleave (MPOL_INTERLEAVE)
+		if(syscall(SYS_get_mempolicy, &mode, &nodes, maxnode, nullptr, 4) == 0 && nodes != 0)
+			syscall(SYS_mbind, p, bytes, 3, &nodes, maxnode, 0);
+	#else
+		(void)p;
+		(void)bytes;
+	#endif
+};
+
+template <class datatype, size_t alignment = 64, int padcells = TN_PADCELLS>
+class TN_AlignedAllocator{
+
+	static_assert((alignment & (alignment - 1)) == 0, "alignment must be a power of two");
+	static_assert(padcells > 0, "padcells must be positive");
+
+	public:
+
+	typedef datatype value_type;
+
+	static constexpr size_t m_alignment = (alignment > alignof(datatype)) ? alignment : alignof(datatype);
+	static constexpr int m_padcells = padcells;
+
+	//alignment of an allocation of n cells. Interleaved allocations of a page or more are
+	//page-aligned, so that whole pages can be placed; smaller ones, e.g. heap matrices, are not.
+	static constexpr size_t allocalign(size_t n){
+		#ifdef TN_INTERLEAVE
+			return (n*sizeof(datatype) >= 4096 && m_alignment < 4096) ? 4096 : m_alignment;
+		#else
+			(void)n;
+			return m_alignment;
+		#endif
+	}
+
+	/*The arena and scope depth the allocator was made in, nullptr and 0 outside any
+	TN_ArenaScope. Allocators of different scopes compare unequal and are not propagated by
+	moves or swaps, so a container made outside a scope copies cells moved into it from one
+	made inside, rather than taking memory that is reused once the scope ends.*/
+	TN_Arena *m_arena = nullptr;
+	int m_depth = 0;
+
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::false_type propagate_on_container_move_assignment;
+	typedef std::false_type propagate_on_container_swap;
+	typedef std::false_type is_always_equal;
+
+	template <class otherdatatype>
+	struct rebind{
+		typedef TN_AlignedAllocator<otherdatatype, alignment, padcells> other;
+	};
+
+	TN_AlignedAllocator(){
+		TN_Arena &arena = TN_Arena::local();
+		if(arena.active()){
+			m_arena = &arena;
+			m_depth = arena.depth();
+		}
+	};
+
+	template <class other>
+	TN_AlignedAllocator(const TN_AlignedAllocator<other, alignment, padcells> &a) :
+		m_arena(a.m_arena), m_depth(a.m_depth){}
+
+	//copies of containers take an allocator of the scope they are made in
+	TN_AlignedAllocator select_on_container_copy_construction() const {
+		return TN_AlignedAllocator();
+	};
+
+	//allocate n cells, rounded up to a whole number of alignment blocks. The memory is
+	//not touched, so its pages are placed by whichever thread first writes to them.
+	//Allocators made inside a TN_ArenaScope take the cells from the thread's arena instead.
+	datatype *allocate(size_t n){
+		const size_t align = allocalign(n);
+		size_t bytes = ((n*sizeof(datatype) + align - 1)/align)*align;
+		if(m_arena && m_arena == &TN_Arena::local() && m_arena->active())
+			return static_cast<datatype *>(m_arena->allocate(bytes, align));
+		void *p = ::operator new(bytes, std::align_val_t(align));
+		if(align >= 4096)
+			TN_Interleave(p, bytes);
+		return static_cast<datatype *>(p);
+	};
+
+	//arena cells are released when their scope ends
+	void deallocate(datatype *p, size_t n) noexcept {
+		if(TN_Arena::local().owns(p))
+			return;
+		::operator delete(p, std::align_val_t(allocalign(n)));
+	};
+
+	//construct without a value, so that resizing a vector does not touch its memory
+	template <class other>
+	void construct(other *p){
+		::new (static_cast<void *>(p)) other;
+	}
+
+	template <class other, class... args>
+	void construct(other *p, args &&... a){
+		::new (static_cast<void *>(p)) other(std::forward<args>(a)...);
+	}
+
+	//padded length of the fastest axis
+	static TN_Index padded(TN_Index nz){
+		return ((nz + padcells - 1)/padcells)*padcells;
+	};
+
+	template <class other>
+	bool operator == (const TN_AlignedAllocator<other, alignment, padcells> &a) const {
+		return m_arena == a.m_arena && m_depth == a.m_depth;
+	}
+
+	template <class other>
+	bool operator != (const TN_AlignedAllocator<other, alignment, padcells> &a) const {
+		return !(*this == a);
+	}
+};
+
+#endif //TN_ALLOCATOR
@@ -0,0 +1,166 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//**************
+//class TN_Arena
+//**************
+//a per-thread arena for short-lived arrays and matrices, released all at once when the
+//TN_ArenaScope that allocated them ends.
+
+#ifndef TN_ARENA
+#define TN_ARENA
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+//size of each block the arena takes from the heap
+#ifndef TN_ARENABYTES
+	#define TN_ARENABYTES (1 << 20)
+#endif
+
+/*While a TN_ArenaScope is open on a thread, TN_Array storage and, with TN_HEAPMATRIX, matrix
+storage of arrays and matrices made on that thread is carved from the thread's arena rather
+than the heap, by bumping a pointer. Freeing it costs nothing; the memory is reused once the scope ends. The
+arena only goes to the heap when its blocks are full, so after the first pass a loop whose
+body is wrapped in a scope makes no heap allocations at all.*/
+class TN_Arena {
+
+	struct block{
+		char *m_data;
+		size_t m_size;
+	};
+
+	static constexpr size_t m_blockalign = 4096; //satisfies every alignment the allocators ask for
+
+	std::vector<block> m_blocks;
+	size_t m_block = 0; //block being allocated from
+	size_t m_used = 0; //bytes used in that block
+	int m_depth = 0; //number of open scopes
+	size_t m_nallocs = 0; //allocations served from the arena
+	size_t m_nblocks = 0; //blocks taken from the heap
+
+	TN_Arena() = default;
+
+	public:
+
+	//position of the arena, to which a scope rewinds it
+	struct mark{
+		size_t m_block, m_used;
+	};
+
+	~TN_Arena(){
+		for(block &b : m_blocks)
+			::operator delete(b.m_data, std::align_val_t(m_blockalign));
+	};
+
+	TN_Arena(const TN_Arena &) = delete;
+	TN_Arena &operator = (const TN_Arena &) = delete;
+
+	//the calling thread's arena
+	static TN_Arena &local(){
+		thread_local TN_Arena arena;
+		return arena;
+	};
+
+	//whether allocations on this thread should come from the arena
+	inline bool active() const {
+		return m_depth > 0;
+	};
+
+	//number of open scopes, which tells the allocators of nested scopes apart
+	inline int depth() const {
+		return m_depth;
+	};
+
+	void *allocate(size_t bytes, size_t alignment){
+		++m_nallocs;
+		while(m_block < m_blocks.size()){
+			block &b = m_blocks[m_block];
+			size_t start = (m_used + alignment - 1)/alignment*alignment;
+			if(start + bytes <= b.m_size){
+				m_used = start + bytes;
+				return b.m_data + start;
+			}
+			++m_block;
+			m_used = 0;
+		}
+		//out of blocks, so take another from the heap, large enough for this allocation
+		size_t size = (bytes > TN_ARENABYTES) ? bytes : size_t(TN_ARENABYTES);
+		size = (size + m_blockalign - 1)/m_blockalign*m_blockalign;
+		m_blocks.push_back(block{static_cast<char *>(::operator new(size, std::align_val_t(m_blockalign))), size});
+		++m_nblocks;
+		m_block = m_blocks.size() - 1;
+		m_used = bytes;
+		return m_blocks[m_block].m_data;
+	};
+
+	//whether p was allocated from this arena
+	inline bool owns(const void *p) const {
+		const char *c = static_cast<const char *>(p);
+		for(const block &b : m_blocks){
+			if(c >= b.m_data && c < b.m_data + b.m_size)
+				return true;
+		}
+		return false;
+	};
+
+	mark begin(){
+		++m_depth;
+		return mark{m_block, m_used};
+	};
+
+	void end(const mark &m){
+		--m_depth;
+		m_block = m.m_block;
+		m_used = m.m_used;
+	};
+
+	//allocation counts, to check that hot loops stay off the heap
+	inline size_t get_nallocs() const {
+		return m_nallocs;
+	};
+
+	inline size_t get_nblocks() const {
+		return m_nblocks;
+	};
+
+	inline size_t get_capacity() const {
+		size_t bytes = 0;
+		for(const block &b : m_blocks)
+			bytes += b.m_size;
+		return bytes;
+	};
+};
+
+/*Opens an arena scope on the calling thread for its lifetime. Scopes nest. Arrays and
+matrices made in a scope must be destroyed, on the same thread, before the scope ends. Results
+that must outlive it are made before it opens, and keep their own memory: assigning or moving
+a temporary of the scope into them copies its cells, e.g.
+	TN_Matrix<double,6,6> inv;
+	{
+		TN_ArenaScope scope;
+		inv = inverse(A); //copied out of the arena
+	}*/
+class TN_ArenaScope {
+
+	TN_Arena &m_arena;
+	TN_Arena::mark m_mark;
+
+	public:
+
+	TN_ArenaScope() : m_arena(TN_Arena::local()), m_mark(m_arena.begin())
+	{};
+
+	~TN_ArenaScope(){
+		m_arena.end(m_mark);
+	};
+
+	TN_ArenaScope(const TN_ArenaScope &) = delete;
+	TN_ArenaScope &operator = (const TN_ArenaScope &) = delete;
+};
+
+#endif //TN_ARENA
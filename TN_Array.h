@@ -12,42 +12,241 @@ TUNGSTEN Arrays of matrices
 #define TN_ARRAY
 
 #include <omp.h>
-#include <vector>
-
-template <class datatype>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+
+/*TN_Array data is allocated through an allocation policy, by default TN_AlignedAllocator,
+which aligns the start of the array to a 64-byte cache line and may pad the fastest (nz)
+axis. With padding, each (i,j) row of nz cells starts on a multiple of the padded length,
+so flat indices i, as used by calc(i), address the padded storage; (i,j,k) indexing and
+get_nz() are unchanged. Arithmetic between arrays is only defined for arrays of the default
+policy; unary functions, comparisons, where() and reductions take any policy.*/
+template <class datatype, class allocator = TN_AlignedAllocator<datatype> >
 class TN_Array {
 
 	protected:
 	
-	int m_nx, m_ny, m_nz; //array size
-	int m_nynz; //used for indexing
-	int m_nt; //total number of cells
+	TN_Index m_nx, m_ny, m_nz; //array size
+	TN_Index m_nzpad; //padded length of the nz axis
+	TN_Index m_nynz; //used for indexing
+	TN_Index m_nt; //total number of cells
+	TN_Index m_ntpad; //total number of cells, including padding
 	double m_dx, m_dy, m_dz; //cell dimensions
 	double m_ox, m_oy, m_oz; //array origin coordinates
-	vector<datatype> m_data; //array data
+	datatype *m_data = nullptr; //array data
+	bool m_owned = true; //whether m_data is allocated by m_alloc, and freed with the array
+	bool m_writable = true; //whether the cells may be written, not e.g. for read-only mappings
+	allocator m_alloc; //allocation policy
 	
 	private:
 	
 	//constructor tools
-	void initialize(int nx, int ny, int nz){
+	void setdims(TN_Index nx, TN_Index ny, TN_Index nz){
 		m_nx = nx;
 		m_ny = ny;
 		m_nz = nz;
-		m_nynz = ny*nz;
+		m_nzpad = allocator::padded(nz);
+		m_nynz = ny*m_nzpad;
 		m_nt = nx*ny*nz;
-			
-		m_data.resize(m_nt);
-		
+		m_ntpad = nx*m_nynz;
+	};
+
+	void initialize(TN_Index nx, TN_Index ny, TN_Index nz){
+		release();
+		setdims(nx, ny, nz);
+		m_data = m_alloc.allocate(m_ntpad);
+		firsttouch();
+	};
+
+	/*The memory is allocated untouched, then its cells are constructed, and zeroed with
+	TN_INITIALIZE, using the same static schedule as the assignment loops. Each page is
+	therefore first touched by, and placed on the NUMA node of, the thread that will
+	later work on it. Without TN_INITIALIZE, cells of trivial types are left untouched
+	until the first assignment, which uses the same schedule.*/
+	void firsttouch(){
+		if(m_nzpad == m_nz){
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index i=0; i<m_ntpad; ++i){
+				construct(i);
+			}
+		}
+		else{
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				for(TN_Index i=row*m_nzpad; i < (row+1)*m_nzpad; ++i){
+					construct(i);
+				}
+			}
+		}
+	};
+
+	inline void construct(TN_Index i){
+		if constexpr (!std::is_trivially_default_constructible_v<datatype>)
+			::new (static_cast<void *>(m_data + i)) datatype;
 		#ifdef TN_INITIALIZE
+			m_data[i] = 0.0;
+		#endif
+	};
+
+	//copy-construct the cells of array into fresh memory, first touching as above
+	void copyconstruct(const TN_Array &array){
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index i=0; i<m_ntpad; ++i){
+			::new (static_cast<void *>(m_data + i)) datatype(array.m_data[i]);
+		}
+	};
+
+	//Array = expression, one cell at a time
+	template<class expr>
+	void assigncells(const expr &expression){
+		if(m_nzpad == m_nz){
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index i=0; i < m_nt; ++i){
+				m_data[i] = expression.calc(i);
+			}
+		}
+		else{ //padded, so assign row by row and skip the padding at the end of each row
 			#ifdef TN_PARALLELARRAY
-				#pragma omp parallel for
+				#pragma omp parallel for schedule(static)
 			#endif
-			for (int i=0; i<m_nt; ++i){
-				m_data[i] = 0.0;
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+					m_data[i] = expression.calc(i);
+				}
 			}
+		}
+	}
+
+	/*update every cell with f(cell, value), where value is the expression's cell, or for
+	scalars, matrices and matrix expressions the expression itself. Expressions that read
+	out-of-core arrays are read a plane at a time, as in operator=.*/
+	template<class expr, class func>
+	TN_Array &updatecells(const expr &expression, func f){
+		if constexpr (TN_IsOutOfCore<expr>::value){
+			for(TN_Index x=0; x < m_nx; ++x){
+				(void)expression.calc(x*m_nynz);
+				updaterows(expression, f, x*m_ny, (x+1)*m_ny);
+			}
+		}else{
+			updaterows(expression, f, 0, m_nx*m_ny);
+		}
+		return *this;
+	}
+
+	//updatecells() for rows [begin,end)
+	template<class expr, class func>
+	void updaterows(const expr &expression, func f, TN_Index begin, TN_Index end){
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
 		#endif
+		for(TN_Index row=begin; row < end; ++row){
+			for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+				if constexpr (TN_HasExtent<expr>::value)
+					f(m_data[i], expression.calc(i));
+				else
+					f(m_data[i], expression);
+			}
+		}
+	}
+
+	/*Array op= expression, by byarray(*this, expression), i.e. Array = Array op expression, where
+	both the array and the expression, or a scalar of its datatype, are evaluated in packets, so
+	that it takes the SIMD path of assignment; otherwise every cell is updated in place by
+	bycell(cell, value) through updatecells()*/
+	template<class expr, class arrayfunc, class cellfunc>
+	TN_Array &compound(const expr &expression, arrayfunc byarray, cellfunc bycell){
+		checkwritable();
+		if constexpr (TN_IsPacketExpr<TN_Array>::value &&
+				(std::is_same_v<expr, datatype> || TN_IsPacketExpr<TN_ArrayOperand<expr> >::value))
+			byarray(*this, expression);
+		else
+			updatecells(expression, bycell);
+		return *this;
+	}
+
+	#ifndef TN_NOSIMD
+	/*Array = expression, a packet of cells at a time, by the kernel for the processor's widest
+	packets. Unpadded arrays are handed to it in blocks of TN_PACKETBLOCK cells, and padded
+	arrays a row at a time, so that the padding is skipped. Expressions that read views are
+	also handed to it a row at a time, with their views bound to the row, see TN_BindRow().*/
+	template<class expr>
+	void assignpackets(const expr &expression){
+		TN_AssignKernel<datatype, expr> kernel = TN_PacketKernel<datatype, expr>();
+		if constexpr (TN_ReadsView<expr>::value){
+			TN_AssignRowKernel<datatype, expr> rowkernel = TN_PacketRowKernel<datatype, expr>();
+			TN_Index nrows = m_nx*m_ny;
+			TN_Index blockrows = std::max(TN_Index(1), TN_PACKETBLOCK/m_nzpad);
+			TN_Index nblocks = (nrows + blockrows - 1)/blockrows;
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index block=0; block < nblocks; ++block){
+				rowkernel(m_data, expression, block*blockrows, std::min(nrows, (block + 1)*blockrows), m_nz, m_nzpad);
+			}
+		}
+		else if(m_nzpad == m_nz){
+			TN_Index nblocks = (m_nt + TN_PACKETBLOCK - 1)/TN_PACKETBLOCK;
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index block=0; block < nblocks; ++block){
+				kernel(m_data, expression, block*TN_PACKETBLOCK, std::min(m_nt, (block + 1)*TN_PACKETBLOCK));
+			}
+		}
+		else{
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				kernel(m_data, expression, row*m_nzpad, row*m_nzpad + m_nz);
+			}
+		}
+	}
+	#endif
+
+	void release(){
+		if(m_data && m_owned){
+			std::destroy_n(m_data, m_ntpad);
+			m_alloc.deallocate(m_data, m_ntpad);
+		}
+		m_data = nullptr;
+	};
+
+	//arrays whose data belongs to a derived class cannot be given other data
+	void checkowned(const char *message) const {
+		if(!m_owned)
+			throw std::logic_error(message);
 	};
 	    
+	protected:
+
+	/*constructor for arrays whose data is provided by a derived class, e.g. TN_MappedArray.
+	No memory is allocated, and the data is never freed, moved or swapped by this class: moves
+	from the array copy its cells, and it cannot be resized or swapped, even through a
+	reference to TN_Array. The derived class must set m_data, and release it itself. Arrays
+that are not writable throw std::logic_error from every assignment, as do views of them.*/
+	TN_Array(TN_Index nx, TN_Index ny, TN_Index nz,
+			double dx, double dy, double dz,
+			double ox, double oy, double oz, datatype *data, bool writable = true){
+		setdims(nx, ny, nz);
+		setcelldims(dx, dy, dz);
+		setorigin(ox, oy, oz);
+		m_data = data;
+		m_owned = false;
+		m_writable = writable;
+	};
+
 	void setcelldims(double dx, double dy, double dz){
 		m_dx = dx;
 	    m_dy = dy;
@@ -63,7 +262,7 @@ class TN_Array {
 	public:
 	
 	//constructor, inc default constructor
-	TN_Array(int nx = 1, int ny = 1, int nz = 1,
+	TN_Array(TN_Index nx = 1, TN_Index ny = 1, TN_Index nz = 1,
 			double dx = 1.0, double dy = 1.0, double dz = 1.0,
 			double ox = 0.0, double oy = 0.0, double oz = 0.0){
 		initialize(nx, ny, nz);
@@ -73,71 +272,201 @@ class TN_Array {
 
 	//destructor
 	virtual ~TN_Array(){
+		release();
 	};
 
-	//disable copy constructors etc
-	//TN_Array(const TN_Array &) = delete;
-	//TN_Array(const TN_Array&) = delete;
-	//TN_Array(TN_Array&&) = delete;
-	//TN_Array& operator=(const TN_Array&) = delete;
-	//TN_Array& operator=(TN_Array&&) = delete;
-	
-
 	//resize
-	void resize(int nx = 1, int ny = 1, int nz = 1,
+	void resize(TN_Index nx = 1, TN_Index ny = 1, TN_Index nz = 1,
 			double dx = 1.0, double dy = 1.0, double dz = 1.0,
 			double ox = 0.0, double oy = 0.0, double oz = 0.0){
+		checkowned("TN_Array::resize: the array does not own its data");
 		initialize(nx, ny, nz);
 		setcelldims(dx, dy, dz);
 		setorigin(ox, oy, oz);
 	};
 
-	//copy constructor
-	//****************
-	TN_Array(const TN_Array &array){	
-		initialize(array.m_nx, array.m_ny, array.m_nz);
+	//copy and move
+	//*************
+
+	//copy constructor, each cell is written once, by the copy
+	TN_Array(const TN_Array &array){
+		setdims(array.m_nx, array.m_ny, array.m_nz);
 		setcelldims(array.m_dx, array.m_dy, array.m_dz);
 		setorigin(array.m_ox, array.m_oy, array.m_oz);
-		std::copy(array.m_data.begin(), array.m_data.end(), m_data.begin());
-		//cout << "Called array copy constructor" << endl;
+		m_data = m_alloc.allocate(m_ntpad);
+		copyconstruct(array);
+	};
+
+	/*move constructor, takes the data of array and leaves it empty. The cells of arrays that do
+	not own their data, or whose data comes from another TN_ArenaScope than the one active here,
+	e.g. one since closed, are copied instead, as by swap, so that no array keeps memory of a
+	scope it outlives.*/
+	TN_Array(TN_Array &&array){
+		setdims(array.m_nx, array.m_ny, array.m_nz);
+		setcelldims(array.m_dx, array.m_dy, array.m_dz);
+		setorigin(array.m_ox, array.m_oy, array.m_oz);
+		if(array.m_owned && array.m_alloc == m_alloc){
+			m_data = array.m_data;
+			array.m_data = nullptr;
+			array.setdims(0, 0, 0);
+		}
+		else{
+			m_data = m_alloc.allocate(m_ntpad);
+			copyconstruct(array);
+		}
+	};
+
+	/*swap, exchanges data without copying, e.g. for time-step buffers. Arrays made in
+	different TN_ArenaScopes exchange their cells instead, so that neither keeps memory of a
+	scope it outlives.*/
+	void swap(TN_Array &array){
+		checkowned("TN_Array::swap: the array does not own its data");
+		array.checkowned("TN_Array::swap: the array does not own its data");
+		if(m_alloc != array.m_alloc){
+			TN_Array copy(*this);
+			*this = array;
+			array = copy;
+			return;
+		}
+		std::swap(m_nx, array.m_nx);
+		std::swap(m_ny, array.m_ny);
+		std::swap(m_nz, array.m_nz);
+		std::swap(m_nzpad, array.m_nzpad);
+		std::swap(m_nynz, array.m_nynz);
+		std::swap(m_nt, array.m_nt);
+		std::swap(m_ntpad, array.m_ntpad);
+		std::swap(m_dx, array.m_dx);
+		std::swap(m_dy, array.m_dy);
+		std::swap(m_dz, array.m_dz);
+		std::swap(m_ox, array.m_ox);
+		std::swap(m_oy, array.m_oy);
+		std::swap(m_oz, array.m_oz);
+		std::swap(m_data, array.m_data);
 	};
 
-	
 	//operators
 	//*********
-	
-	//Array = double or int etc
-	TN_Array<datatype> operator = (const datatype &value){
+
+	//Array = Array, reuses the existing data when the sizes match
+	TN_Array &operator = (const TN_Array &array){
+		checkwritable();
+		if(this != &array){
+			if(m_ntpad != array.m_ntpad){
+				checkowned("TN_Array: cannot resize an array that does not own its data");
+				release();
+				setdims(array.m_nx, array.m_ny, array.m_nz);
+				m_data = m_alloc.allocate(m_ntpad);
+				copyconstruct(array);
+			}
+			else{
+				setdims(array.m_nx, array.m_ny, array.m_nz);
+				std::copy_n(array.m_data, m_ntpad, m_data);
+			}
+			setcelldims(array.m_dx, array.m_dy, array.m_dz);
+			setorigin(array.m_ox, array.m_oy, array.m_oz);
+		}
+		return *this;
+	};
+
+	/*Array = moved Array, copying the cells when either array does not own its data, or they
+	were made in different TN_ArenaScopes*/
+	TN_Array &operator = (TN_Array &&array){
+		if(m_owned && array.m_owned && m_alloc == array.m_alloc)
+			swap(array);
+		else
+			*this = static_cast<const TN_Array &>(array);
+		return *this;
+	};
+
+	//Array = double or int etc, padding included
+	TN_Array &operator = (const datatype &value){
+		checkwritable();
 		#ifdef TN_PARALLELARRAY
-			#pragma omp parallel for
+			#pragma omp parallel for schedule(static)
 		#endif
-		for (int i=0; i<m_nt; ++i){
+		for(TN_Index i=0; i<m_ntpad; ++i){
             m_data[i] = value;
         }
 		return *this;
 	};
 
 	template<typename expr>
-    TN_Array<datatype> &operator = (const expr &expression){
-    
-		#ifdef TN_PARALLELARRAY
-			#pragma omp parallel for
+    TN_Array &operator = (const expr &expression){
+		checkwritable();
+
+		if constexpr (TN_IsOutOfCore<expr>::value){
+			/*one x plane at a time, first reading one cell of the plane serially so that the
+			tiles of out-of-core arrays it needs are loaded before the threads read them*/
+			for(TN_Index x=0; x < m_nx; ++x){
+				(void)expression.calc(x*m_nynz);
+				#ifdef TN_PARALLELARRAY
+					#pragma omp parallel for schedule(static)
+				#endif
+				for(TN_Index row=x*m_ny; row < (x+1)*m_ny; ++row){
+					for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+						m_data[i] = expression.calc(i);
+					}
+				}
+			}
+		}
+		#ifndef TN_NOSIMD
+		else if constexpr (TN_IsPacketExpr<expr>::value){
+			if(TN_GetSimdLevel() != TN_SIMDNONE)
+				assignpackets(expression);
+			else
+				assigncells(expression);
+		}
 		#endif
-		for(int i=0; i < m_nt; ++i){
-			m_data[i] = expression.calc(i);
+		else{
+			assigncells(expression);
 		}
 		return *this;
 	}
 
+	//Compound assignment
+	//*******************
+
+	/*Array op= expression updates every cell in place, in one pass, for arrays of any policy.
+	Arrays of doubles or floats of the default policy are evaluated as Array = Array op
+	expression where the expression can be evaluated in packets, so that they take the same
+	SIMD path, and otherwise, as are other arrays, cell by cell. The cells of arrays of
+	matrices are updated by the matrix op=, so that *= by arrays of square matrices is the
+	per-cell matrix product, computed safely in place.*/
+	template<typename expr>
+	TN_Array &operator += (const expr &expression){
+		return compound(expression, [](auto &array, const auto &value){ array = array + value; },
+			[](datatype &cell, const auto &value){ cell += value; });
+	}
+
+	template<typename expr>
+	TN_Array &operator -= (const expr &expression){
+		return compound(expression, [](auto &array, const auto &value){ array = array - value; },
+			[](datatype &cell, const auto &value){ cell -= value; });
+	}
+
+	template<typename expr>
+	TN_Array &operator *= (const expr &expression){
+		return compound(expression, [](auto &array, const auto &value){ array = array * value; },
+			[](datatype &cell, const auto &value){ cell *= value; });
+	}
+
+	template<typename expr>
+	TN_Array &operator /= (const expr &expression){
+		return compound(expression, [](auto &array, const auto &value){ array = array / value; },
+			[](datatype &cell, const auto &value){ cell /= value; });
+	}
+
 	//Array == Array
-	bool operator == (const TN_Array<datatype> &a){
+	bool operator == (const TN_Array &a){
 		
 		bool equalarrays = true;
-		for (int i=0; i<m_nt; ++i){
-			if(m_data[i] != a(i)){
-            	equalarrays = false;
-				return equalarrays;
-            }
+		for(TN_Index row=0; row < m_nx*m_ny; ++row){
+			for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+				if(m_data[i] != a(i)){
+					equalarrays = false;
+					return equalarrays;
+				}
+			}
         }
         return equalarrays;
 	};
@@ -147,17 +476,23 @@ class TN_Array {
 
 	#include <cstdlib>
 	void setrandom(int min=0, int max=9){
+		checkwritable();
 		if constexpr (	std::is_same_v<int, datatype> ||
 						std::is_same_v<long int, datatype> ||
+						std::is_same_v<float, datatype> ||
 						std::is_same_v<double, datatype> ||
 						std::is_same_v<long double, datatype>) {
-			for(int i=0;i<m_nt;++i){
-				m_data[i] = datatype(rand() % (max+1 - min) + min);
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+					m_data[i] = datatype(rand() % (max+1 - min) + min);
+				}
 			}
 		}
 		else{ //datatype = TN_Matrix
-			for(int i=0;i<m_nt;++i){
-				m_data[i].setrandom(min,max);
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+					m_data[i].setrandom(min,max);
+				}
 			}
 		}
 	};
@@ -176,6 +511,7 @@ class TN_Array {
 	const datatype v27=0, const datatype v28=0, const datatype v29=0,
 	const datatype v30=0, const datatype v31=0, const datatype v32=0,
 	const datatype v33=0, const datatype v34=0, const datatype v35=0 ){
+		checkwritable();
 		datatype values[] = {
 			v00,v01,v02,v03,v04,v05,
 			v06,v07,v08,v09,v10,v11,
@@ -184,8 +520,11 @@ class TN_Array {
 			v24,v25,v26,v27,v28,v29,
 			v30,v31,v32,v33,v34,v35};
 			
-		for(int i=0;i<m_nt;++i){
-			m_data[i] = values[i];
+		TN_Index v = 0;
+		for(TN_Index row=0; row < m_nx*m_ny; ++row){
+			for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+				m_data[i] = values[v++];
+			}
 		}
 	};
 	
@@ -193,54 +532,145 @@ class TN_Array {
 	//*************
 	
 	//[i] indexing
-	inline const datatype & operator[](int i) const {
+	inline const datatype & operator[](TN_Index i) const {
 		return m_data[i];
 	};
 
 	//(i) indexing
-	inline const datatype & operator()(int i) const {
+	inline const datatype & operator()(TN_Index i) const {
 		return m_data[i];
 	};
 	
 	//(i,j,k) indexing
-	inline const datatype & operator()(int i, int j, int k) const {
-		return m_data[(i*m_nynz)+(j*m_nz)+k];
+	inline const datatype & operator()(TN_Index i, TN_Index j, TN_Index k) const {
+		return m_data[(i*m_nynz)+(j*m_nzpad)+k];
 	};
 	
 	//calc(i) indexing
-	inline const datatype &calc(int i) const {
+	inline const datatype &calc(TN_Index i) const {
 		return m_data[i];
 	};
 
+	#ifndef TN_NOSIMD
+	//calc_packet(i), the width cells from i on
+	template<int width>
+	inline TN_Packet<datatype, width> calc_packet(TN_Index i) const {
+		return TN_Packet<datatype, width>::load(m_data + i);
+	}
+	#endif
+
 	//Write-indexing
 	//**************
+
+	/*cells of arrays that are not writable, e.g. read-only mappings, must only be indexed
+	through const references, as writes through these fault rather than throw*/
 	
 	//(i) indexing
-	inline datatype & operator()(int i) {
+	inline datatype & operator()(TN_Index i) {
 		return m_data[i];
 	};
 	
 	//(i,j,k) indexing
-	inline datatype & operator()(int i, int j, int k) {
-		return m_data[(i*m_nynz)+(j*m_nz)+k];
+	inline datatype & operator()(TN_Index i, TN_Index j, TN_Index k) {
+		return m_data[(i*m_nynz)+(j*m_nzpad)+k];
 	};
 
-	inline int get_nx() const {
+	inline TN_Index get_nx() const {
 		return m_nx;
 	};
 
-	inline int get_ny() const {
+	inline TN_Index get_ny() const {
 		return m_ny;
 	};
 
-	inline int get_nz() const {
+	inline TN_Index get_nz() const {
 		return m_nz;
 	};
 
-	inline int get_nt() const {
+	inline TN_Index get_nt() const {
 		return m_nt;
 	};
 
+	//padded length of the nz axis, and the stride between (i,j) rows
+	inline TN_Index get_nzpad() const {
+		return m_nzpad;
+	};
+
+	//total number of cells, including padding
+	inline TN_Index get_ntpad() const {
+		return m_ntpad;
+	};
+
+	//start of the data, aligned as the allocation policy guarantees
+	inline const datatype *data() const {
+		return m_data;
+	};
+
+	inline datatype *data() {
+		return m_data;
+	};
+
+	//whether the cells may be written, and the check that throws std::logic_error where not
+	inline bool writable() const {
+		return m_writable;
+	};
+
+	void checkwritable() const {
+		if(!m_writable)
+			throw std::logic_error("TN_Array: cannot write to a read-only array");
+	};
+
+	//Views
+	//*****
+
+	/*view of the cells in ranges ri, rj and rk, e.g. a.view(TN_Range(0,nx,2), ...) for every
+	other x. Views write through to this array, and must not outlive it. Views of const arrays
+	are TN_ConstArrayViews, which cannot be written.*/
+	inline TN_ArrayView<datatype,allocator> view(const TN_Range &ri, const TN_Range &rj, const TN_Range &rk) {
+		return TN_ArrayView<datatype,allocator>(m_data, m_nynz, m_nzpad, ri, rj, rk, m_writable);
+	};
+
+	inline TN_ConstArrayView<datatype,allocator> view(const TN_Range &ri, const TN_Range &rj, const TN_Range &rk) const {
+		return TN_ConstArrayView<datatype,allocator>(TN_ArrayView<datatype,allocator>(m_data, m_nynz, m_nzpad, ri, rj, rk));
+	};
+
+	//single planes, of constant i, j or k
+	inline TN_ArrayView<datatype,allocator> slicex(TN_Index i) {
+		return view(TN_Range(i,i+1), TN_Range(0,m_ny), TN_Range(0,m_nz));
+	};
+
+	inline TN_ConstArrayView<datatype,allocator> slicex(TN_Index i) const {
+		return view(TN_Range(i,i+1), TN_Range(0,m_ny), TN_Range(0,m_nz));
+	};
+
+	inline TN_ArrayView<datatype,allocator> slicey(TN_Index j) {
+		return view(TN_Range(0,m_nx), TN_Range(j,j+1), TN_Range(0,m_nz));
+	};
+
+	inline TN_ConstArrayView<datatype,allocator> slicey(TN_Index j) const {
+		return view(TN_Range(0,m_nx), TN_Range(j,j+1), TN_Range(0,m_nz));
+	};
+
+	inline TN_ArrayView<datatype,allocator> slicez(TN_Index k) {
+		return view(TN_Range(0,m_nx), TN_Range(0,m_ny), TN_Range(k,k+1));
+	};
+
+	inline TN_ConstArrayView<datatype,allocator> slicez(TN_Index k) const {
+		return view(TN_Range(0,m_nx), TN_Range(0,m_ny), TN_Range(k,k+1));
+	};
+
+	/*read-only view of this array as an array of nx*ny*nz cells, repeating it along each axis
+	on which it has a single cell, e.g. a depth profile of (1,1,nz) cells, or a surface map of
+	(nx,ny,1), as a full (nx,ny,nz) array. Along every other axis the sizes must match. The
+	view takes part in expressions with arrays of that size without storing the repeated
+	cells, at the cost of reading a view. It is a TN_ConstArrayView, which cannot be written.*/
+	inline TN_ConstArrayView<datatype,allocator> broadcast(TN_Index nx, TN_Index ny, TN_Index nz) const {
+		if((m_nx != nx && m_nx != 1) || (m_ny != ny && m_ny != 1) || (m_nz != nz && m_nz != 1))
+			throw std::invalid_argument("TN_Array::broadcast: sizes differ on an axis of more than one cell");
+		return TN_ConstArrayView<datatype,allocator>(TN_ArrayView<datatype,allocator>(m_data, nx, ny, nz,
+			(m_nx == nx) ? m_nynz : 0, (m_ny == ny) ? m_nzpad : 0, (m_nz == nz) ? 1 : 0));
+	};
+
 	inline int get_dx() const {
 		return m_dx;
 	};
@@ -268,35 +698,32 @@ class TN_Array {
 	//Min/Max
 	//*******
 
-	//overload for general case
-	datatype min() {
-		datatype minimum = m_data[0];
-		for(int i=1; i < m_nt; ++i){
-			if(m_data[i] < minimum)
-				minimum = m_data[i];
-		}
-		return minimum;
+	//the least and greatest cells, as a parallel reduction, see TN_Reduce.h
+	datatype min() const {
+		return TN_ExtremeCell<datatype, false>(*this);
 	};
 	
-	datatype max() {
-		datatype maximum = m_data[0];
-		for(int i=1; i < m_nt; ++i){
-			if(m_data[i] > maximum)
-				maximum = m_data[i];
-		}
-		return maximum;
+	datatype max() const {
+		return TN_ExtremeCell<datatype, true>(*this);
 	};
 	
 };
 
+//swap
+//****
+template<class datatype, class allocator>
+inline void swap(TN_Array<datatype,allocator> &a, TN_Array<datatype,allocator> &b){
+	a.swap(b);
+};
+
 //overloaded "<<" operator
 //************************
-template<class datatype>
-std::ostream &operator<<(std::ostream &s, const TN_Array<datatype> &array){
+template<class datatype, class allocator>
+std::ostream &operator<<(std::ostream &s, const TN_Array<datatype,allocator> &array){
 	s << "Array[" << array.get_nx() << "," << array.get_ny() << ","  << array.get_nz() << "] :" << endl;
-	for(int i=0; i<array.get_nx(); ++i){
-		for(int j=0; j<array.get_ny(); ++j){
-			for(int k=0; k<array.get_nz(); ++k){
+	for(TN_Index i=0; i<array.get_nx(); ++i){
+		for(TN_Index j=0; j<array.get_ny(); ++j){
+			for(TN_Index k=0; k<array.get_nz(); ++k){
 				s << array(i,j,k) << " ";
 			}
 			s << endl;
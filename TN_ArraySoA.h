@@ -0,0 +1,580 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//************************************
+//class TN_Array<TN_Matrix>, SoA layout
+//************************************
+//with #define TN_SOAARRAYSOFMATRICES, arrays of matrices are stored as one contiguous
+//plane of nx*ny*nz cells per matrix component (row,col), rather than as whole matrices.
+//The same component of neighbouring cells is then adjacent in memory, so expressions
+//are evaluated plane by plane with unit stride.
+
+#ifndef TN_ARRAYSOA
+#define TN_ARRAYSOA
+
+#ifdef TN_SOAARRAYSOFMATRICES
+
+#include <ostream>
+#include <vector>
+#include <memory>
+#include <utility>
+
+//TN_MatrixPlanes locates the planes of a SoA array; component i of a cell is
+//found m_nplane values after component i-1
+template <class datatype>
+struct TN_MatrixPlanes{
+	const datatype *m_data; //first component of the cell
+	TN_Index m_nplane; //cells per plane
+};
+
+//PlaneOp reads a matrix component out of the planes, so a SoA cell can be presented to
+//the operator overloads as a MatBinExpr, exactly like any other matrix expression
+struct PlaneOp
+{
+	template <class datatype>
+	static inline const datatype & calc(const TN_MatrixPlanes<datatype> &A, const TN_Index & /*B*/, TN_Index i)
+	{
+		return A.m_data[i*A.m_nplane];
+	}
+};
+
+//writable reference to one cell of a SoA array of matrices
+template <class datatype, int nrows, int ncols>
+class TN_MatrixPlaneRef{
+
+	protected:
+
+	datatype *m_data; //first component of the cell
+	TN_Index m_nplane; //cells per plane
+
+	public:
+
+	TN_MatrixPlaneRef(datatype *data, TN_Index nplane) : m_data(data), m_nplane(nplane){};
+
+	//Matrix(i) and Matrix(row,col) indexing
+	inline datatype & operator[](TN_Index i) const {
+		return m_data[i*m_nplane];
+	};
+
+	inline datatype & operator()(int row, int col) const {
+		return m_data[(row*ncols+col)*m_nplane];
+	};
+
+	inline const datatype & calc(TN_Index i) const {
+		return m_data[i*m_nplane];
+	};
+
+	//assignment by datatype, matrix or matrix expression
+	const TN_MatrixPlaneRef &operator=(const datatype &val) const {
+		for(TN_Index i=0;i<nrows*ncols;++i)
+			m_data[i*m_nplane] = val;
+		return *this;
+	};
+
+	const TN_MatrixPlaneRef &operator=(const TN_Matrix<datatype,nrows,ncols> &m) const {
+		for(TN_Index i=0;i<nrows*ncols;++i)
+			m_data[i*m_nplane] = m[i];
+		return *this;
+	};
+
+	template<class LHS, class Op, class RHS, class RtnType>
+	const TN_MatrixPlaneRef &operator=(const MatBinExpr<LHS,Op,RHS,nrows,ncols,RtnType> &expression) const {
+		for(TN_Index i=0;i<nrows*ncols;++i)
+			m_data[i*m_nplane] = expression.calc(i);
+		return *this;
+	}
+
+	//gather the cell into a matrix
+	operator TN_Matrix<datatype,nrows,ncols>() const {
+		TN_Matrix<datatype,nrows,ncols> m;
+		for(TN_Index i=0;i<nrows*ncols;++i)
+			m[i] = m_data[i*m_nplane];
+		return m;
+	};
+};
+
+template<class datatype,int nrows,int ncols>
+std::ostream &operator<<(std::ostream &s, const TN_MatrixPlaneRef<datatype,nrows,ncols> &m){
+	return s << TN_Matrix<datatype,nrows,ncols>(m);
+};
+
+template <class datatype, int nrows, int ncols, class allocator>
+class TN_Array<TN_Matrix<datatype,nrows,ncols>, allocator> {
+
+	//the planes hold matrix components, so are allocated by the policy rebound to datatype
+	typedef typename std::allocator_traits<allocator>::template rebind_alloc<datatype> planeallocator;
+
+	protected:
+
+	TN_Index m_nx, m_ny, m_nz; //array size
+	TN_Index m_nzpad; //padded length of the nz axis
+	TN_Index m_nynz; //used for indexing
+	TN_Index m_nt; //total number of cells
+	TN_Index m_ntpad; //total number of cells, including padding
+	TN_Index m_nplane; //distance between planes, a whole number of 64-byte blocks
+	double m_dx, m_dy, m_dz; //cell dimensions
+	double m_ox, m_oy, m_oz; //array origin coordinates
+	vector<datatype,planeallocator> m_data; //array data, nrows*ncols planes of m_nplane cells
+
+	static constexpr int m_ncomp = nrows*ncols; //number of planes
+
+	private:
+
+	//constructor tools
+	void initialize(TN_Index nx, TN_Index ny, TN_Index nz){
+		m_nx = nx;
+		m_ny = ny;
+		m_nz = nz;
+		m_nzpad = allocator::padded(nz);
+		m_nynz = ny*m_nzpad;
+		m_nt = nx*ny*nz;
+		m_ntpad = nx*m_nynz;
+
+		constexpr TN_Index blockcells = (64 % sizeof(datatype) == 0) ? 64/sizeof(datatype) : 1;
+		m_nplane = ((m_ntpad + blockcells - 1)/blockcells)*blockcells;
+
+		//the policy constructs without a value, so resizing leaves the memory untouched
+		m_data.resize(m_ncomp*m_nplane);
+
+		//with TN_INITIALIZE, first touch each plane with the schedule of the assignment loops
+		#ifdef TN_INITIALIZE
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel
+			#endif
+			for(int c=0; c<m_ncomp; ++c){
+				datatype *plane = &m_data[c*m_nplane];
+				#ifdef TN_PARALLELARRAY
+					#pragma omp for schedule(static)
+				#endif
+				for(TN_Index row=0; row < m_nx*m_ny; ++row){
+					for(TN_Index i=row*m_nzpad; i < (row+1)*m_nzpad; ++i){
+						plane[i] = 0.0;
+					}
+				}
+			}
+		#endif
+	};
+
+	void setcelldims(double dx, double dy, double dz){
+		m_dx = dx;
+	    m_dy = dy;
+	    m_dz = dz;
+	};
+
+	void setorigin(double ox, double oy, double oz){
+		m_ox = ox;
+		m_oy = oy;
+		m_oz = oz;
+	};
+
+	//component c of a scalar, which is the same in every component, or of a matrix
+	template<class value>
+	static inline datatype component(const value &v, int c){
+		if constexpr (std::is_arithmetic_v<value>)
+			return v;
+		else
+			return v.calc(c);
+	}
+
+	//whether the cells of expr, or expr itself if it is not an array, are scalars
+	template<class expr>
+	static constexpr bool scalarcells(){
+		if constexpr (TN_IsArrayExpr<expr>::value)
+			return std::is_arithmetic_v<std::decay_t<decltype(std::declval<const expr &>().calc(TN_Index(0)))> >;
+		else
+			return std::is_arithmetic_v<expr>;
+	}
+
+	//whether the cells of an array expression contain nested products to materialise, see TN_Plan.h
+	template<class expr>
+	static constexpr bool plannedcells(){
+		if constexpr (TN_IsArrayExpr<expr>::value)
+			return TN_IsPlanned<std::decay_t<decltype(std::declval<const expr &>().calc(TN_Index(0)))> >::value;
+		else
+			return false;
+	}
+
+	//update every component with f(component, value), one plane at a time
+	template<class expr, class func>
+	TN_Array &updateplanes(const expr &expression, func f){
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel
+		#endif
+		for(int c=0; c<m_ncomp; ++c){
+			datatype *plane = &m_data[c*m_nplane];
+			#ifdef TN_PARALLELARRAY
+				#pragma omp for schedule(static)
+			#endif
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+					if constexpr (TN_IsArrayExpr<expr>::value)
+						f(plane[i], component(expression.calc(i), c));
+					else
+						f(plane[i], component(expression, c));
+				}
+			}
+		}
+		return *this;
+	}
+
+	/*update every cell with f(matrix, value), a cell at a time, gathering the cell into a
+	matrix and back. Used for products, which read every component of a cell, so each cell is
+	computed in full before any of its components is written.*/
+	template<class expr, class func>
+	TN_Array &updatecells(const expr &expression, func f){
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index row=0; row < m_nx*m_ny; ++row){
+			for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+				TN_MatrixPlaneRef<datatype,nrows,ncols> cell = (*this)(i);
+				matrixtype m = cell;
+				if constexpr (TN_IsArrayExpr<expr>::value)
+					f(m, expression.calc(i));
+				else
+					f(m, expression);
+				cell = m;
+			}
+		}
+		return *this;
+	}
+
+	public:
+
+	typedef TN_Matrix<datatype,nrows,ncols> matrixtype;
+
+	//read-only cell, usable wherever a matrix expression is
+	typedef MatBinExpr<TN_MatrixPlanes<datatype>,PlaneOp,TN_Index,nrows,ncols,datatype> celltype;
+
+	//constructor, inc default constructor
+	TN_Array(TN_Index nx = 1, TN_Index ny = 1, TN_Index nz = 1,
+			double dx = 1.0, double dy = 1.0, double dz = 1.0,
+			double ox = 0.0, double oy = 0.0, double oz = 0.0){
+		initialize(nx, ny, nz);
+		setcelldims(dx, dy, dz);
+		setorigin(ox, oy, oz);
+	};
+
+	//destructor
+	virtual ~TN_Array(){
+	};
+
+	//resize
+	void resize(TN_Index nx = 1, TN_Index ny = 1, TN_Index nz = 1,
+			double dx = 1.0, double dy = 1.0, double dz = 1.0,
+			double ox = 0.0, double oy = 0.0, double oz = 0.0){
+		initialize(nx, ny, nz);
+		setcelldims(dx, dy, dz);
+		setorigin(ox, oy, oz);
+	};
+
+	//copy and move
+	//*************
+
+	//copy constructor, each cell is written once, by the copy
+	TN_Array(const TN_Array &) = default;
+
+	/*move constructor, takes the data of array and leaves it empty, or copies the planes of
+	arrays made in another TN_ArenaScope than the one active here, as swap does*/
+	TN_Array(TN_Array &&array) :
+		m_nx(array.m_nx), m_ny(array.m_ny), m_nz(array.m_nz),
+		m_nzpad(array.m_nzpad), m_nynz(array.m_nynz),
+		m_nt(array.m_nt), m_ntpad(array.m_ntpad), m_nplane(array.m_nplane),
+		m_dx(array.m_dx), m_dy(array.m_dy), m_dz(array.m_dz),
+		m_ox(array.m_ox), m_oy(array.m_oy), m_oz(array.m_oz),
+		m_data(std::move(array.m_data), planeallocator()){
+		array.m_data.clear();
+		array.m_data.shrink_to_fit();
+		array.m_nx = array.m_ny = array.m_nz = 0;
+		array.m_nzpad = array.m_nynz = 0;
+		array.m_nt = array.m_ntpad = array.m_nplane = 0;
+	};
+
+	//Array = Array
+	TN_Array &operator = (const TN_Array &) = default;
+
+	//Array = moved Array
+	TN_Array &operator = (TN_Array &&array){
+		swap(array);
+		return *this;
+	};
+
+	/*swap, exchanges data without copying, e.g. for time-step buffers, or the cells of arrays
+	made in different TN_ArenaScopes*/
+	void swap(TN_Array &array){
+		if(m_data.get_allocator() != array.m_data.get_allocator()){
+			TN_Array copy(*this);
+			*this = array;
+			array = copy;
+			return;
+		}
+		std::swap(m_nx, array.m_nx);
+		std::swap(m_ny, array.m_ny);
+		std::swap(m_nz, array.m_nz);
+		std::swap(m_nzpad, array.m_nzpad);
+		std::swap(m_nynz, array.m_nynz);
+		std::swap(m_nt, array.m_nt);
+		std::swap(m_ntpad, array.m_ntpad);
+		std::swap(m_nplane, array.m_nplane);
+		std::swap(m_dx, array.m_dx);
+		std::swap(m_dy, array.m_dy);
+		std::swap(m_dz, array.m_dz);
+		std::swap(m_ox, array.m_ox);
+		std::swap(m_oy, array.m_oy);
+		std::swap(m_oz, array.m_oz);
+		m_data.swap(array.m_data);
+	};
+
+	//operators
+	//*********
+
+	//Array = Matrix, padding included
+	TN_Array &operator = (const matrixtype &m){
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel
+		#endif
+		for(int c=0; c<m_ncomp; ++c){
+			datatype *plane = &m_data[c*m_nplane];
+			#ifdef TN_PARALLELARRAY
+				#pragma omp for schedule(static)
+			#endif
+			for(TN_Index i=0; i<m_ntpad; ++i){
+				plane[i] = m[c];
+			}
+		}
+		return *this;
+	};
+
+	/*Array = expression, evaluated one plane at a time, row by row to skip any padding. An
+	expression that reads this array through a product, e.g. a = a * b, or whose cells have
+	nested products worth materialising, is evaluated a cell at a time instead, each cell into
+	a matrix before it is written.*/
+	template<typename expr>
+	TN_Array &operator = (const expr &expression){
+		if constexpr (plannedcells<expr>())
+			return updatecells(expression, [](matrixtype &m, const auto &value){ m = value; });
+		if(TN_Aliases(expression, this))
+			return updatecells(expression, [](matrixtype &m, const auto &value){ m = value; });
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel
+		#endif
+		for(int c=0; c<m_ncomp; ++c){
+			datatype *plane = &m_data[c*m_nplane];
+			#ifdef TN_PARALLELARRAY
+				#pragma omp for schedule(static)
+			#endif
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+					plane[i] = expression.calc(i).calc(c);
+				}
+			}
+		}
+		return *this;
+	}
+
+	//Compound assignment
+	//*******************
+
+	/*Array op= expression updates the planes in place, one at a time. *= by arrays of square
+	matrices, or a square matrix, is the per-cell matrix product instead, which reads every
+	component of a cell, so it is done a cell at a time, as are expressions that read this array
+	through a product.*/
+	template<typename expr>
+	TN_Array &operator += (const expr &expression){
+		if(TN_Aliases(expression, this))
+			return updatecells(expression, [](matrixtype &m, const auto &value){ m += value; });
+		return updateplanes(expression, [](datatype &c, const datatype &value){ c += value; });
+	}
+
+	template<typename expr>
+	TN_Array &operator -= (const expr &expression){
+		if(TN_Aliases(expression, this))
+			return updatecells(expression, [](matrixtype &m, const auto &value){ m -= value; });
+		return updateplanes(expression, [](datatype &c, const datatype &value){ c -= value; });
+	}
+
+	template<typename expr>
+	TN_Array &operator *= (const expr &expression){
+		if constexpr (scalarcells<expr>())
+			return updateplanes(expression, [](datatype &c, const datatype &value){ c *= value; });
+		else
+			return updatecells(expression, [](matrixtype &m, const auto &value){ m *= value; });
+	}
+
+	template<typename expr>
+	TN_Array &operator /= (const expr &expression){
+		static_assert(scalarcells<expr>(), "arrays of matrices can only be divided by scalars");
+		return updateplanes(expression, [](datatype &c, const datatype &value){ c /= value; });
+	}
+
+	//Array == Array
+	bool operator == (const TN_Array &a){
+		for(int c=0; c<m_ncomp; ++c){
+			for(TN_Index row=0; row < m_nx*m_ny; ++row){
+				for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+					if(m_data[c*m_nplane+i] != a.m_data[c*a.m_nplane+i])
+						return false;
+				}
+			}
+		}
+		return true;
+	};
+
+	//assign values
+	//*************
+
+	//fills cell by cell, so the values match those of the default layout
+	void setrandom(int min=0, int max=9){
+		for(TN_Index row=0; row < m_nx*m_ny; ++row){
+			for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+				for(int c=0;c<m_ncomp;++c){
+					m_data[c*m_nplane+i] = rand() % (max + 1 - min) + min;
+				}
+			}
+		}
+	};
+
+	//Read-indexing
+	//*************
+
+	//[i] indexing
+	inline celltype operator[](TN_Index i) const {
+		return calc(i);
+	};
+
+	//(i) indexing
+	inline celltype operator()(TN_Index i) const {
+		return calc(i);
+	};
+
+	//(i,j,k) indexing
+	inline celltype operator()(TN_Index i, TN_Index j, TN_Index k) const {
+		return calc((i*m_nynz)+(j*m_nzpad)+k);
+	};
+
+	//calc(i) indexing
+	inline celltype calc(TN_Index i) const {
+		return celltype(TN_MatrixPlanes<datatype>{&m_data[i], m_nplane}, 0);
+	};
+
+	//Write-indexing
+	//**************
+
+	//(i) indexing
+	inline TN_MatrixPlaneRef<datatype,nrows,ncols> operator()(TN_Index i) {
+		return TN_MatrixPlaneRef<datatype,nrows,ncols>(&m_data[i], m_nplane);
+	};
+
+	//(i,j,k) indexing
+	inline TN_MatrixPlaneRef<datatype,nrows,ncols> operator()(TN_Index i, TN_Index j, TN_Index k) {
+		return (*this)((i*m_nynz)+(j*m_nzpad)+k);
+	};
+
+	//Plane access
+	//************
+
+	//contiguous plane of component (row,col)
+	inline datatype *plane(int row, int col) {
+		return &m_data[(row*ncols+col)*m_nplane];
+	};
+
+	inline const datatype *plane(int row, int col) const {
+		return &m_data[(row*ncols+col)*m_nplane];
+	};
+
+	inline TN_Index get_nx() const {
+		return m_nx;
+	};
+
+	inline TN_Index get_ny() const {
+		return m_ny;
+	};
+
+	inline TN_Index get_nz() const {
+		return m_nz;
+	};
+
+	inline TN_Index get_nt() const {
+		return m_nt;
+	};
+
+	//padded length of the nz axis, and the stride between (i,j) rows
+	inline TN_Index get_nzpad() const {
+		return m_nzpad;
+	};
+
+	//total number of cells, including padding
+	inline TN_Index get_ntpad() const {
+		return m_ntpad;
+	};
+
+	//arrays of matrices always own, and may write, their planes
+	inline bool writable() const {
+		return true;
+	};
+
+	void checkwritable() const {};
+
+	inline int get_dx() const {
+		return m_dx;
+	};
+
+	inline int get_dy() const {
+		return m_dy;
+	};
+
+	inline int get_dz() const {
+		return m_dz;
+	};
+
+	inline int get_ox() const {
+		return m_ox;
+	};
+
+	inline int get_oy() const {
+		return m_oy;
+	};
+
+	inline int get_oz() const {
+		return m_oz;
+	};
+
+	//Min/Max
+	//*******
+
+	//as for the default layout, cells are ordered by their smallest and largest components
+	matrixtype min() const {
+		return TN_ExtremeCell<matrixtype, false>(*this);
+	};
+
+	matrixtype max() const {
+		return TN_ExtremeCell<matrixtype, true>(*this);
+	};
+
+};
+
+//overloaded "<<" operator
+//************************
+template<class datatype, int nrows, int ncols, class allocator>
+std::ostream &operator<<(std::ostream &s, const TN_Array<TN_Matrix<datatype,nrows,ncols>, allocator> &array){
+	TN_Matrix<datatype,nrows,ncols> cell;
+	s << "Array[" << array.get_nx() << "," << array.get_ny() << ","  << array.get_nz() << "] :" << endl;
+	for(TN_Index i=0; i<array.get_nx(); ++i){
+		for(TN_Index j=0; j<array.get_ny(); ++j){
+			for(TN_Index k=0; k<array.get_nz(); ++k){
+				cell = array(i,j,k);
+				s << cell << " ";
+			}
+			s << endl;
+		}
+		s << endl;
+	}
+    return s;
+};
+
+#endif //TN_SOAARRAYSOFMATRICES
+
+#endif //TN_ARRAYSOA
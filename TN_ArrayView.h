@@ -0,0 +1,353 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//******************
+//class TN_ArrayView
+//******************
+//a window onto part of an existing TN_Array: an index range, optionally strided, along each
+//axis. Views do not own or copy data, and may appear wherever an array may in an expression.
+
+#ifndef TN_ARRAYVIEW
+#define TN_ARRAYVIEW
+
+#include <omp.h>
+#include <stdexcept>
+
+//the half-open index range [start, end), taking every stride'th index
+struct TN_Range{
+	TN_Index m_start, m_end, m_stride;
+
+	TN_Range(TN_Index start, TN_Index end, TN_Index stride = 1) : m_start(start),
+		m_end(end), m_stride(stride)
+	{};
+
+	inline TN_Index size() const {
+		return (m_end > m_start) ? (m_end - m_start + m_stride - 1)/m_stride : 0;
+	};
+};
+
+/*quotients by a fixed positive divisor, through a multiplication by its reciprocal and a
+correction of one either way, which is exact for quotients below 2^52, rather than an integer
+division*/
+struct TN_Divisor{
+	TN_Index m_d;
+	double m_r;
+
+	TN_Divisor(TN_Index d) : m_d(d), m_r((d > 0) ? 1.0/double(d) : 0.0)
+	{};
+
+	inline TN_Index quotient(TN_Index i) const {
+		TN_Index q = TN_Index(double(i)*m_r);
+		TN_Index r = i - q*m_d;
+		if(r < 0)
+			--q;
+		else if(r >= m_d)
+			++q;
+		return q;
+	};
+};
+
+/*A view of nx*ny*nz cells takes part in expressions exactly as a TN_Array of that size would,
+i.e. its flat index i runs over an (nx,ny,nz) array padded as the allocation policy pads one,
+so views, and arrays the size of the view, can be mixed freely. Reading a view at a flat index
+recovers (i,j,k) with two divisions by the view's row lengths, through TN_Divisor, whereas
+assigning to a view walks its rows directly, so only the cells of the view are touched. Arrays
+assigned expressions that read views in packets bind the views to each row in turn instead,
+see TN_BindRow(), so that the start of the row is found once and its cells are read without
+divisions. Views of doubles or floats are read a packet at a time, see TN_Simd.h, where their
+cells along z are contiguous, or repeated, as in a broadcast, and one cell at a time elsewhere.*/
+template <class datatype, class allocator = TN_AlignedAllocator<datatype> >
+class TN_ArrayView {
+
+	protected:
+
+	datatype *m_data; //first cell of the view in the parent array
+	TN_Index m_nx, m_ny, m_nz; //view size
+	TN_Index m_nzpad; //padded length of the nz axis, as for an array of the view's size
+	TN_Index m_sx, m_sy, m_sz; //distance in the parent data between neighbouring view cells
+	TN_Divisor m_rows, m_cols; //divisions of flat indices by m_nzpad, and of rows by m_ny
+	bool m_writable; //whether the parent array's cells may be written
+	TN_Index m_rowfirst; //flat index of the row bound by bindrow(), or -1 if none
+	TN_Index m_rowcell; //distance in the parent data from m_data to the first cell of that row
+
+	private:
+
+	/*assign expression, row by row, skipping the rest of the parent array. Expressions that read
+	out-of-core arrays are assigned a plane at a time, first reading one cell of the plane
+	serially, as in TN_Array::operator=.*/
+	template<typename expr>
+	void assign(const expr &expression){
+		checkwritable();
+		if constexpr (TN_IsOutOfCore<expr>::value){
+			for(TN_Index x=0; x < m_nx; ++x){
+				(void)expression.calc(x*m_ny*m_nzpad);
+				assignrows(expression, x*m_ny, (x+1)*m_ny);
+			}
+		}else{
+			assignrows(expression, 0, m_nx*m_ny);
+		}
+	}
+
+	//assign expression to rows [begin,end) of the view
+	template<typename expr>
+	void assignrows(const expr &expression, TN_Index begin, TN_Index end){
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index row=begin; row < end; ++row){
+			TN_Index i = row/m_ny;
+			TN_Index j = row - i*m_ny;
+			datatype *cell = m_data + i*m_sx + j*m_sy;
+			TN_Index first = row*m_nzpad;
+			for(TN_Index k=0; k < m_nz; ++k){
+				cell[k*m_sz] = expression.calc(first + k);
+			}
+		}
+	}
+
+	public:
+
+	/*data is the first cell of the parent array, nynz and nzpad its strides, and ri, rj and
+	rk the ranges of the view, which throws std::logic_error from assignments unless writable.
+	Views are usually made with TN_Array::view() or slicex() etc.*/
+	TN_ArrayView(datatype *data, TN_Index nynz, TN_Index nzpad,
+			const TN_Range &ri, const TN_Range &rj, const TN_Range &rk, bool writable = true) :
+		m_data(data + ri.m_start*nynz + rj.m_start*nzpad + rk.m_start),
+		m_nx(ri.size()), m_ny(rj.size()), m_nz(rk.size()),
+		m_nzpad(allocator::padded(rk.size())),
+		m_sx(ri.m_stride*nynz), m_sy(rj.m_stride*nzpad), m_sz(rk.m_stride),
+		m_rows(m_nzpad), m_cols(m_ny), m_writable(writable), m_rowfirst(-1), m_rowcell(0)
+	{};
+
+	/*data is the first cell of the view, nx, ny and nz its size, and sx, sy and sz the distances
+	in the parent data between neighbouring cells along each axis. A distance of 0 repeats the
+	cell along that axis, as TN_Array::broadcast() does.*/
+	TN_ArrayView(datatype *data, TN_Index nx, TN_Index ny, TN_Index nz,
+			TN_Index sx, TN_Index sy, TN_Index sz, bool writable = true) :
+		m_data(data), m_nx(nx), m_ny(ny), m_nz(nz), m_nzpad(allocator::padded(nz)),
+		m_sx(sx), m_sy(sy), m_sz(sz), m_rows(m_nzpad), m_cols(m_ny), m_writable(writable),
+		m_rowfirst(-1), m_rowcell(0)
+	{};
+
+	TN_ArrayView(const TN_ArrayView &view) = default;
+
+	//operators
+	//*********
+
+	//View = View, copies the cells, not the view
+	TN_ArrayView &operator = (const TN_ArrayView &view){
+		assign(view);
+		return *this;
+	};
+
+	//View = double or int etc
+	TN_ArrayView &operator = (const datatype &value){
+		checkwritable();
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index row=0; row < m_nx*m_ny; ++row){
+			TN_Index i = row/m_ny;
+			TN_Index j = row - i*m_ny;
+			datatype *cell = m_data + i*m_sx + j*m_sy;
+			for(TN_Index k=0; k < m_nz; ++k){
+				cell[k*m_sz] = value;
+			}
+		}
+		return *this;
+	};
+
+	/*View = expression, for arrays and expressions the size of the view. The expression must
+	not read cells of the same parent array that the view overwrites, other than the cell
+	being written.*/
+	template<typename expr>
+	TN_ArrayView &operator = (const expr &expression){
+		assign(expression);
+		return *this;
+	}
+
+	void checkwritable() const {
+		if(!m_writable)
+			throw std::logic_error("TN_ArrayView: cannot write to a view of a read-only array");
+	};
+
+	//Indexing
+	//********
+
+	//(i,j,k) indexing, relative to the view
+	inline const datatype & operator()(TN_Index i, TN_Index j, TN_Index k) const {
+		return m_data[i*m_sx + j*m_sy + k*m_sz];
+	};
+
+	inline datatype & operator()(TN_Index i, TN_Index j, TN_Index k) {
+		return m_data[i*m_sx + j*m_sy + k*m_sz];
+	};
+
+	/*a copy of the view that reads the cells of the given row, from row*nzpad on, without
+	divisions. It must only be read at flat indices in that row.*/
+	TN_ArrayView bindrow(TN_Index row) const {
+		TN_ArrayView view(*this);
+		TN_Index ii = m_cols.quotient(row);
+		view.m_rowfirst = row*m_nzpad;
+		view.m_rowcell = ii*m_sx + (row - ii*m_ny)*m_sy;
+		return view;
+	};
+
+	//calc(i) indexing, i in the padded index space of an array the size of the view
+	inline const datatype &calc(TN_Index i) const {
+		if(m_rowfirst >= 0)
+			return m_data[m_rowcell + (i - m_rowfirst)*m_sz];
+		TN_Index row = m_rows.quotient(i);
+		TN_Index k = i - row*m_nzpad;
+		TN_Index ii = m_cols.quotient(row);
+		TN_Index jj = row - ii*m_ny;
+		return m_data[ii*m_sx + jj*m_sy + k*m_sz];
+	};
+
+	#ifndef TN_NOSIMD
+	/*width cells from i on, loaded or broadcast together if they lie in one row and the view's
+	cells along z are contiguous or repeated, and otherwise read one at a time*/
+	template<int width>
+	inline TN_Packet<datatype, width> calc_packet(TN_Index i) const {
+		typedef TN_Packet<datatype, width> packet;
+		if(m_rowfirst >= 0 && (m_sz == 1 || m_sz == 0)){
+			const datatype *cell = m_data + m_rowcell;
+			return (m_sz == 1) ? packet::load(cell + (i - m_rowfirst)) : packet::broadcast(*cell);
+		}
+		TN_Index row = m_rows.quotient(i);
+		TN_Index k = i - row*m_nzpad;
+		if(k + width <= m_nz && (m_sz == 1 || m_sz == 0)){
+			TN_Index ii = m_cols.quotient(row);
+			const datatype *cell = m_data + ii*m_sx + (row - ii*m_ny)*m_sy;
+			return (m_sz == 1) ? packet::load(cell + k) : packet::broadcast(*cell);
+		}
+		datatype cells[width];
+		for(int l=0; l < width; ++l){
+			cells[l] = calc(i + l);
+		}
+		return packet::load(cells);
+	}
+	#endif
+
+	inline TN_Index get_nx() const {
+		return m_nx;
+	};
+
+	inline TN_Index get_ny() const {
+		return m_ny;
+	};
+
+	inline TN_Index get_nz() const {
+		return m_nz;
+	};
+
+	inline TN_Index get_nt() const {
+		return m_nx*m_ny*m_nz;
+	};
+
+	inline TN_Index get_nzpad() const {
+		return m_nzpad;
+	};
+};
+
+//**********************
+//class TN_ConstArrayView
+//**********************
+
+/*A view that cannot be written, as given by the const view(), slices and broadcast() of
+TN_Array, so that copying it does not give write access to a const array. It hides the
+indexing and assignments of TN_ArrayView that write, and takes part in expressions as the
+TN_ArrayView it derives from; assigning to it through a reference to that throws
+std::logic_error.*/
+template <class datatype, class allocator = TN_AlignedAllocator<datatype> >
+class TN_ConstArrayView : public TN_ArrayView<datatype, allocator> {
+
+	public:
+
+	explicit TN_ConstArrayView(const TN_ArrayView<datatype, allocator> &view) :
+		TN_ArrayView<datatype, allocator>(view)
+	{
+		this->m_writable = false;
+	};
+
+	TN_ConstArrayView(const TN_ConstArrayView &view) = default;
+
+	TN_ConstArrayView &operator = (const TN_ConstArrayView &) = delete;
+
+	inline const datatype & operator()(TN_Index i, TN_Index j, TN_Index k) const {
+		return TN_ArrayView<datatype, allocator>::operator()(i, j, k);
+	};
+};
+
+/*TN_ReadsView<expr>::value is true for views and for expressions of arrays built from them.
+TN_BindRow(expression, row) rebuilds such an expression with its views bound to the given row,
+see bindrow(); the result has the same type, and reads the same cells of that row.*/
+template<class T>
+struct TN_ReadsView : std::false_type {};
+
+template<class datatype, class allocator>
+struct TN_HasExtent<TN_ArrayView<datatype, allocator> > : std::true_type {};
+
+template<class datatype, class allocator>
+struct TN_HasExtent<TN_ConstArrayView<datatype, allocator> > : std::true_type {};
+
+template<class datatype, class allocator>
+struct TN_ReadsView<TN_ArrayView<datatype, allocator> > : std::true_type {};
+
+template<class datatype, class allocator>
+struct TN_ReadsView<TN_ConstArrayView<datatype, allocator> > : std::true_type {};
+
+template<class LHS, class Op, class RHS, class datatype>
+struct TN_ReadsView<ArrBinExpr<LHS, Op, RHS, datatype> > :
+	std::bool_constant<TN_ReadsView<LHS>::value || TN_ReadsView<RHS>::value> {};
+
+//arrays and scalars are read as they are
+template<class T>
+inline const T &TN_BindRow(const T &operand, TN_Index){
+	return operand;
+};
+
+template<class datatype, class allocator>
+inline TN_ArrayView<datatype, allocator> TN_BindRow(const TN_ArrayView<datatype, allocator> &view, TN_Index row){
+	return view.bindrow(row);
+};
+
+template<class datatype, class allocator>
+inline TN_ConstArrayView<datatype, allocator> TN_BindRow(const TN_ConstArrayView<datatype, allocator> &view, TN_Index row){
+	return TN_ConstArrayView<datatype, allocator>(view.bindrow(row));
+};
+
+template<class LHS, class Op, class RHS, class datatype>
+inline ArrBinExpr<LHS, Op, RHS, datatype> TN_BindRow(const ArrBinExpr<LHS, Op, RHS, datatype> &expression, TN_Index row){
+	return ArrBinExpr<LHS, Op, RHS, datatype>(TN_BindRow(expression.left(), row), TN_BindRow(expression.right(), row));
+};
+
+#ifndef TN_NOSIMD
+template<class datatype>
+struct TN_IsPacketExpr<TN_ArrayView<datatype, TN_AlignedAllocator<datatype> > > : TN_IsPacketType<datatype> {};
+
+template<class datatype>
+struct TN_IsPacketExpr<TN_ConstArrayView<datatype, TN_AlignedAllocator<datatype> > > : TN_IsPacketType<datatype> {};
+#endif
+
+//overloaded "<<" operator
+//************************
+template<class datatype, class allocator>
+std::ostream &operator<<(std::ostream &s, const TN_ArrayView<datatype,allocator> &view){
+	s << "ArrayView[" << view.get_nx() << "," << view.get_ny() << ","  << view.get_nz() << "] :" << endl;
+	for(TN_Index i=0; i<view.get_nx(); ++i){
+		for(TN_Index j=0; j<view.get_ny(); ++j){
+			for(TN_Index k=0; k<view.get_nz(); ++k){
+				s << view(i,j,k) << " ";
+			}
+			s << endl;
+		}
+		s << endl;
+	}
+    return s;
+};
+
+#endif //TN_ARRAYVIEW
@@ -0,0 +1,1018 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//**************************************
+//Batched inverse, determinant and solve
+//**************************************
+//inverse(), determinant(), the solves and the symmetric eigen-decomposition of the matrix in every
+//cell of an array of matrices.
+
+#ifndef TN_BATCHED
+#define TN_BATCHED
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+/*The matrices of a batch of cells, as many as a SIMD packet holds, are gathered component by
+component into packets, so that the packet for component (r,c) holds that component of every
+cell in the batch. inverse(), determinant() and solve() are then computed for the whole batch
+at once, by the same closed forms as single matrices up to 4x4, and by Gaussian elimination
+with partial pivoting above that, pivoting each cell of the batch on its own row by blending
+rather than branching. Batching pays for the inverse of matrices above 4x4, e.g. 6x6; up to
+4x4 gathering and scattering the packets costs more than the closed forms save, so inverse()
+applies them a cell at a time instead, unless TN_HEAPMATRIX would allocate every cell. solvecholesky() and solveldlt() solve symmetric systems with TN_Cholesky
+and TN_LDLT's factorisations of each cell's lower triangle, which need no pivoting. The batches
+are spread over threads with TN_PARALLELARRAY. Cells that cannot be solved, e.g. singular
+matrices, are given a zero inverse or solution and marked with 1 in a mask, which is 0
+elsewhere, rather than thrown as by inverse() and solve() of single matrices. eigensymmetric() diagonalises each cell's symmetric
+matrix by Jacobi rotations, the same for every cell of the batch until all have converged. They take matrices of floating-point datatypes; those
+without packets, e.g. long double, and all of them with TN_NOSIMD or TN_SIMDNONE, are batched a
+cell at a time.*/
+
+//Lanes
+//*****
+
+//the operations the batched kernels need on a packet of width cells
+template<class datatype, int width>
+struct TN_Lanes;
+
+//a single cell, for datatypes without packets
+template<class datatype>
+struct TN_Lanes<datatype, 1>{
+
+	typedef datatype celltype;
+	typedef datatype lane;
+	static constexpr int width = 1;
+
+	static inline lane broadcast(const datatype &x){
+		return x;
+	}
+
+	static inline lane load(const datatype *p){
+		return *p;
+	}
+
+	static inline void store(const lane &x, datatype *p){
+		*p = x;
+	}
+
+	//cell l of x
+	static inline void set(lane &x, int /*l*/, const datatype &value){
+		x = value;
+	}
+
+	//a where mask is not 0, otherwise b
+	static inline lane select(const lane &mask, const lane &a, const lane &b){
+		return (mask != 0) ? a : b;
+	}
+
+	//masks, 1 where the condition holds and 0 where it does not
+	static inline lane iszero(const lane &a){
+		return (a == 0) ? 1 : 0;
+	}
+
+	static inline lane greater(const lane &a, const lane &b){
+		return (a > b) ? 1 : 0;
+	}
+
+	static inline lane equal(const lane &a, const lane &b){
+		return (a == b) ? 1 : 0;
+	}
+
+	static inline lane abs(const lane &a){
+		return (a < 0) ? -a : a;
+	}
+
+	static inline lane sqrt(const lane &a){
+		return std::sqrt(a);
+	}
+
+	//whether mask is set in any cell
+	static inline bool any(const lane &mask){
+		return mask != 0;
+	}
+};
+
+#ifndef TN_NOSIMD
+
+template<class datatype, int width_>
+struct TN_Lanes{
+
+	typedef datatype celltype;
+	typedef TN_Packet<datatype, width_> lane;
+	static constexpr int width = width_;
+
+	static inline lane broadcast(const datatype &x){
+		return lane::broadcast(x);
+	}
+
+	static inline lane load(const datatype *p){
+		return lane::load(p);
+	}
+
+	static inline void store(const lane &x, datatype *p){
+		x.store(p);
+	}
+
+	static inline void set(lane &x, int l, const datatype &value){
+		x.m_v[l] = value;
+	}
+
+	static inline lane select(const lane &mask, const lane &a, const lane &b){
+		return lane::select(mask.m_v != 0, a, b);
+	}
+
+	static inline lane iszero(const lane &a){
+		return lane::select(a.m_v == 0, broadcast(1), broadcast(0));
+	}
+
+	static inline lane greater(const lane &a, const lane &b){
+		return lane::select(a.m_v > b.m_v, broadcast(1), broadcast(0));
+	}
+
+	static inline lane equal(const lane &a, const lane &b){
+		return lane::select(a.m_v == b.m_v, broadcast(1), broadcast(0));
+	}
+
+	static inline lane abs(const lane &a){
+		return lane::select(a.m_v < 0, -a, a);
+	}
+
+	static inline lane sqrt(const lane &a){
+		return SqrtOp::apply_packet(a, datatype(0));
+	}
+
+	static inline bool any(const lane &mask){
+		for(int l=0; l < width; ++l)
+			if(mask.m_v[l] != 0)
+				return true;
+		return false;
+	}
+};
+
+#endif
+
+//a batch of matrices, held as one packet per component
+template<class lane, int nrows, int ncols>
+struct TN_LaneMatrix{
+
+	lane m_v[(nrows*ncols > 0) ? nrows*ncols : 1];
+
+	inline lane & operator()(int row, int col){
+		return m_v[row*ncols+col];
+	}
+
+	inline const lane & operator()(int row, int col) const {
+		return m_v[row*ncols+col];
+	}
+};
+
+//Gather and scatter
+//******************
+
+//batches of count < width cells are filled by repeating their last cell, and only count are written back
+
+template<class lanes, class datatype, int nrows, int ncols, class allocator>
+inline void TN_BatchGather(const TN_Array<TN_Matrix<datatype,nrows,ncols>, allocator> &A, TN_Index i, int count,
+						   TN_LaneMatrix<typename lanes::lane,nrows,ncols> &M)
+{
+	constexpr int width = lanes::width;
+	#ifdef TN_SOAARRAYSOFMATRICES
+		//the planes already hold the batch component by component
+		if(count == width){
+			for(int c=0; c < nrows*ncols; ++c)
+				M.m_v[c] = lanes::load(A.plane(c/ncols, c%ncols) + i);
+			return;
+		}
+	#endif
+	TN_Index cells[width];
+	for(int l=0; l < width; ++l)
+		cells[l] = i + std::min(l, count - 1);
+	//each packet is filled in registers, from its first cell on
+	for(int c=0; c < nrows*ncols; ++c){
+		#ifdef TN_SOAARRAYSOFMATRICES
+			const datatype *plane = A.plane(c/ncols, c%ncols);
+			M.m_v[c] = lanes::broadcast(plane[cells[0]]);
+			for(int l=1; l < width; ++l)
+				lanes::set(M.m_v[c], l, plane[cells[l]]);
+		#else
+			M.m_v[c] = lanes::broadcast(A(cells[0])(c));
+			for(int l=1; l < width; ++l)
+				lanes::set(M.m_v[c], l, A(cells[l])(c));
+		#endif
+	}
+}
+
+template<class lanes, class datatype, int nrows, int ncols, class allocator>
+inline void TN_BatchScatter(const TN_LaneMatrix<typename lanes::lane,nrows,ncols> &M, TN_Index i, int count,
+							TN_Array<TN_Matrix<datatype,nrows,ncols>, allocator> &A)
+{
+	constexpr int width = lanes::width;
+	#ifdef TN_SOAARRAYSOFMATRICES
+		if(count == width){
+			for(int c=0; c < nrows*ncols; ++c)
+				lanes::store(M.m_v[c], A.plane(c/ncols, c%ncols) + i);
+			return;
+		}
+	#endif
+	datatype cells[nrows*ncols][width];
+	for(int c=0; c < nrows*ncols; ++c)
+		lanes::store(M.m_v[c], cells[c]);
+	for(int l=0; l < count; ++l){
+		for(int c=0; c < nrows*ncols; ++c){
+			#ifdef TN_SOAARRAYSOFMATRICES
+				A.plane(c/ncols, c%ncols)[i + l] = cells[c][l];
+			#else
+				A(i + l)[c] = cells[c][l];
+			#endif
+		}
+	}
+}
+
+template<class lanes, class datatype, class allocator>
+inline void TN_BatchScatter(const typename lanes::lane &x, TN_Index i, int count, TN_Array<datatype, allocator> &A)
+{
+	if(count == lanes::width){
+		lanes::store(x, &A(i));
+		return;
+	}
+	datatype cells[lanes::width];
+	lanes::store(x, cells);
+	for(int l=0; l < count; ++l)
+		A(i + l) = cells[l];
+}
+
+//Kernels
+//*******
+
+/*Gaussian elimination with partial pivoting of [A | B], leaving A upper triangular with the
+reciprocals of its pivots in rpivot. det is the determinant, and singular 1 in the cells with
+no pivot in some column, whose pivot is taken as 1 so that no cell divides by zero.*/
+template<class lanes, int n, int m>
+inline void TN_BatchEliminate(TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,m> &B,
+							  typename lanes::lane *rpivot, typename lanes::lane &det, typename lanes::lane &singular)
+{
+	typedef typename lanes::lane lane;
+	const lane one = lanes::broadcast(1);
+	det = one;
+	singular = lanes::broadcast(0);
+
+	for(int c=0; c < n; ++c){
+		//the row of the largest remaining cell of the column, cell by cell
+		lane largest = lanes::abs(A(c,c));
+		lane p = lanes::broadcast(c);
+		for(int r=c+1; r < n; ++r){
+			lane a = lanes::abs(A(r,c));
+			lane larger = lanes::greater(a, largest);
+			largest = lanes::select(larger, a, largest);
+			p = lanes::select(larger, lanes::broadcast(r), p);
+		}
+
+		//swap it into row c in the cells whose pivot is not already there
+		for(int r=c+1; r < n; ++r){
+			lane swap = lanes::equal(p, lanes::broadcast(r));
+			for(int k=c; k < n; ++k){
+				lane t = A(c,k);
+				A(c,k) = lanes::select(swap, A(r,k), t);
+				A(r,k) = lanes::select(swap, t, A(r,k));
+			}
+			for(int k=0; k < m; ++k){
+				lane t = B(c,k);
+				B(c,k) = lanes::select(swap, B(r,k), t);
+				B(r,k) = lanes::select(swap, t, B(r,k));
+			}
+		}
+		det = lanes::select(lanes::equal(p, lanes::broadcast(c)), det, -det)*A(c,c);
+
+		lane zero = lanes::iszero(largest);
+		singular = lanes::select(zero, one, singular);
+		rpivot[c] = one/lanes::select(zero, one, A(c,c));
+
+		//eliminate the column below the pivot
+		for(int r=c+1; r < n; ++r){
+			lane l = A(r,c)*rpivot[c];
+			for(int k=c+1; k < n; ++k)
+				A(r,k) = A(r,k) - l*A(c,k);
+			for(int k=0; k < m; ++k)
+				B(r,k) = B(r,k) - l*B(c,k);
+		}
+	}
+}
+
+//X = A^-1 B in place of B, from TN_BatchEliminate, with the singular cells 0
+template<class lanes, int n, int m>
+inline void TN_BatchBackSubstitute(const TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,m> &B,
+								   const typename lanes::lane *rpivot, const typename lanes::lane &singular)
+{
+	typedef typename lanes::lane lane;
+	const lane zero = lanes::broadcast(0);
+	for(int j=0; j < m; ++j){
+		for(int r=n-1; r >= 0; --r){
+			lane x = B(r,j);
+			for(int k=r+1; k < n; ++k)
+				x = x - A(r,k)*B(k,j);
+			B(r,j) = x*rpivot[r];
+		}
+		for(int r=0; r < n; ++r)
+			B(r,j) = lanes::select(singular, zero, B(r,j));
+	}
+}
+
+template<class lanes, int n>
+inline typename lanes::lane TN_BatchDeterminant(TN_LaneMatrix<typename lanes::lane,n,n> &A)
+{
+	if constexpr (n == 1){
+		return A(0,0);
+	}else if constexpr (n == 2){
+		return TN_Determinant2(A);
+	}else if constexpr (n == 3){
+		return TN_Determinant3(A);
+	}else if constexpr (n == 4){
+		return TN_Minors4<typename lanes::lane>(A).determinant();
+	}else{
+		typename lanes::lane rpivot[n], det, singular;
+		TN_LaneMatrix<typename lanes::lane,n,0> none;
+		TN_BatchEliminate<lanes>(A, none, rpivot, det, singular);
+		return det;
+	}
+}
+
+//inv = A^-1, overwriting A, with singular 1 where A has no inverse and inv 0
+template<class lanes, int n>
+inline void TN_BatchInverse(TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,n> &inv,
+							typename lanes::lane &singular)
+{
+	typedef typename lanes::lane lane;
+	const lane zero = lanes::broadcast(0), one = lanes::broadcast(1);
+	if constexpr (n <= 4){
+		//the adjoint times one reciprocal of the determinant, which is 0 for singular cells
+		lane det;
+		if constexpr (n == 4){
+			TN_Minors4<lane> minors(A);
+			det = minors.determinant();
+			singular = lanes::iszero(det);
+			lane rdet = lanes::select(singular, zero, one/lanes::select(singular, one, det));
+			TN_Adjoint4(A, minors, inv, [&rdet](const lane &x){ return x*rdet; });
+		}else{
+			det = TN_BatchDeterminant<lanes>(A);
+			singular = lanes::iszero(det);
+			lane rdet = lanes::select(singular, zero, one/lanes::select(singular, one, det));
+			if constexpr (n == 1)
+				inv(0,0) = rdet;
+			else if constexpr (n == 2)
+				TN_Adjoint2(A, inv, [&rdet](const lane &x){ return x*rdet; });
+			else
+				TN_Adjoint3(A, inv, [&rdet](const lane &x){ return x*rdet; });
+		}
+	}else{
+		//eliminate against the identity
+		for(int r=0; r < n; ++r)
+			for(int c=0; c < n; ++c)
+				inv(r,c) = (r == c) ? one : zero;
+		lane rpivot[n], det;
+		TN_BatchEliminate<lanes>(A, inv, rpivot, det, singular);
+		TN_BatchBackSubstitute<lanes>(A, inv, rpivot, singular);
+	}
+}
+
+//X such that AX = B, overwriting A and B, with singular 1 where A has no inverse and X 0
+template<class lanes, int n, int m>
+inline void TN_BatchSolve(TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,m> &B,
+						  TN_LaneMatrix<typename lanes::lane,n,m> &X, typename lanes::lane &singular)
+{
+	typedef typename lanes::lane lane;
+	if constexpr (n <= 4){
+		TN_LaneMatrix<lane,n,n> inv;
+		TN_BatchInverse<lanes>(A, inv, singular);
+		for(int r=0; r < n; ++r){
+			for(int j=0; j < m; ++j){
+				lane x = inv(r,0)*B(0,j);
+				for(int k=1; k < n; ++k)
+					x = x + inv(r,k)*B(k,j);
+				X(r,j) = x;
+			}
+		}
+	}else{
+		lane rpivot[n], det;
+		TN_BatchEliminate<lanes>(A, B, rpivot, det, singular);
+		TN_BatchBackSubstitute<lanes>(A, B, rpivot, singular);
+		X = B;
+	}
+}
+
+/*X such that AX = B by Cholesky factorisation, read from A's lower triangle and overwriting
+it with L, with failed 1 where A is not positive definite and X 0*/
+template<class lanes, int n, int m>
+inline void TN_BatchCholesky(TN_LaneMatrix<typename lanes::lane,n,n> &A, const TN_LaneMatrix<typename lanes::lane,n,m> &B,
+							 TN_LaneMatrix<typename lanes::lane,n,m> &X, typename lanes::lane &failed)
+{
+	typedef typename lanes::lane lane;
+	const lane zero = lanes::broadcast(0), one = lanes::broadcast(1);
+	lane rdiag[n]; //reciprocals of L's diagonal
+	failed = zero;
+	for(int j=0; j < n; ++j){
+		lane d = A(j,j);
+		for(int k=0; k < j; ++k)
+			d = d - A(j,k)*A(j,k);
+		//pivots that are not positive are taken as 1
+		lane positive = lanes::greater(d, zero);
+		failed = lanes::select(positive, failed, one);
+		A(j,j) = lanes::sqrt(lanes::select(positive, d, one));
+		rdiag[j] = one/A(j,j);
+		for(int r=j+1; r < n; ++r){
+			lane x = A(r,j);
+			for(int k=0; k < j; ++k)
+				x = x - A(r,k)*A(j,k);
+			A(r,j) = x*rdiag[j];
+		}
+	}
+	for(int c=0; c < m; ++c){
+		for(int r=0; r < n; ++r){
+			lane y = B(r,c);
+			for(int k=0; k < r; ++k)
+				y = y - A(r,k)*X(k,c);
+			X(r,c) = y*rdiag[r];
+		}
+		for(int r=n-1; r >= 0; --r){
+			lane x = X(r,c);
+			for(int k=r+1; k < n; ++k)
+				x = x - A(k,r)*X(k,c);
+			X(r,c) = lanes::select(failed, zero, x*rdiag[r]);
+		}
+	}
+}
+
+/*X such that AX = B by LDL^T factorisation, read from A's lower triangle and overwriting it
+with L and D, with singular 1 where a pivot is 0 and X 0*/
+template<class lanes, int n, int m>
+inline void TN_BatchLDLT(TN_LaneMatrix<typename lanes::lane,n,n> &A, const TN_LaneMatrix<typename lanes::lane,n,m> &B,
+						 TN_LaneMatrix<typename lanes::lane,n,m> &X, typename lanes::lane &singular)
+{
+	typedef typename lanes::lane lane;
+	const lane zero = lanes::broadcast(0), one = lanes::broadcast(1);
+	lane rdiag[n], v[n]; //reciprocals of D, and row j of L times D
+	singular = zero;
+	for(int j=0; j < n; ++j){
+		lane d = A(j,j);
+		for(int k=0; k < j; ++k){
+			v[k] = A(j,k)*A(k,k);
+			d = d - A(j,k)*v[k];
+		}
+		//zero pivots are taken as 1
+		lane pivotzero = lanes::iszero(d);
+		singular = lanes::select(pivotzero, one, singular);
+		A(j,j) = lanes::select(pivotzero, one, d);
+		rdiag[j] = one/A(j,j);
+		for(int r=j+1; r < n; ++r){
+			lane x = A(r,j);
+			for(int k=0; k < j; ++k)
+				x = x - A(r,k)*v[k];
+			A(r,j) = x*rdiag[j];
+		}
+	}
+	for(int c=0; c < m; ++c){
+		for(int r=0; r < n; ++r){
+			lane y = B(r,c);
+			for(int k=0; k < r; ++k)
+				y = y - A(r,k)*X(k,c);
+			X(r,c) = y;
+		}
+		for(int r=n-1; r >= 0; --r){
+			lane x = X(r,c)*rdiag[r];
+			for(int k=r+1; k < n; ++k)
+				x = x - A(k,r)*X(k,c);
+			X(r,c) = x;
+		}
+		for(int r=0; r < n; ++r)
+			X(r,c) = lanes::select(singular, zero, X(r,c));
+	}
+}
+
+//sweeps of TN_BatchJacobi at most, far more than the few that converge to rounding
+static constexpr int TN_JACOBISWEEPS = 32;
+
+/*Eigenvalues, ascending, and with withvectors the eigenvectors, as the columns of V, of the
+symmetric matrices read from A's lower triangle, by cyclic Jacobi rotations. Each rotation zeroes
+one off-diagonal cell in every cell of the batch, and sweeps over them all continue until the
+off-diagonal cells of every cell are negligible beside its diagonal. Overwrites A.*/
+template<class lanes, int n, bool withvectors>
+inline void TN_BatchJacobi(TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,1> &values,
+						   TN_LaneMatrix<typename lanes::lane,n,n> &V)
+{
+	typedef typename lanes::lane lane;
+	typedef typename lanes::celltype datatype;
+	const lane zero = lanes::broadcast(0), one = lanes::broadcast(1);
+	const datatype eps = std::numeric_limits<datatype>::epsilon();
+	//beyond which theta^2 overflows, and t is 1/(2 theta) to rounding anyway
+	const lane big = lanes::broadcast(std::sqrt(std::numeric_limits<datatype>::max())/4);
+
+	for(int r=0; r < n; ++r)
+		for(int c=r+1; c < n; ++c)
+			A(r,c) = A(c,r);
+	if constexpr (withvectors){
+		for(int r=0; r < n; ++r)
+			for(int c=0; c < n; ++c)
+				V(r,c) = (r == c) ? one : zero;
+	}
+
+	for(int sweep=0; sweep < TN_JACOBISWEEPS; ++sweep){
+		lane off = zero, diag = zero;
+		for(int r=0; r < n; ++r){
+			diag = diag + A(r,r)*A(r,r);
+			for(int c=r+1; c < n; ++c)
+				off = off + A(r,c)*A(r,c);
+		}
+		if(!lanes::any(lanes::greater(off, diag*(eps*eps))))
+			break;
+
+		for(int p=0; p < n; ++p){
+			for(int q=p+1; q < n; ++q){
+				//the rotation by tan t zeroing A(p,q), none where it is already 0
+				lane apq = A(p,q);
+				lane skip = lanes::iszero(apq);
+				lane theta = (A(q,q) - A(p,p))/(lanes::select(skip, one, apq)*2);
+				lane atheta = lanes::abs(theta);
+				atheta = lanes::select(lanes::greater(atheta, big), big, atheta);
+				lane t = one/(atheta + lanes::sqrt(atheta*atheta + one));
+				t = lanes::select(lanes::greater(zero, theta), -t, t);
+				t = lanes::select(skip, zero, t);
+				lane c = one/lanes::sqrt(t*t + one);
+				lane s = t*c;
+
+				A(p,p) = A(p,p) - t*apq;
+				A(q,q) = A(q,q) + t*apq;
+				A(p,q) = zero;
+				A(q,p) = zero;
+				for(int k=0; k < n; ++k){
+					if(k == p || k == q)
+						continue;
+					lane akp = A(k,p), akq = A(k,q);
+					A(k,p) = c*akp - s*akq;
+					A(k,q) = s*akp + c*akq;
+					A(p,k) = A(k,p);
+					A(q,k) = A(k,q);
+				}
+				if constexpr (withvectors){
+					for(int k=0; k < n; ++k){
+						lane vkp = V(k,p), vkq = V(k,q);
+						V(k,p) = c*vkp - s*vkq;
+						V(k,q) = s*vkp + c*vkq;
+					}
+				}
+			}
+		}
+	}
+
+	//sort each cell's eigenvalues, and their eigenvectors with them, by compare and swap
+	for(int r=0; r < n; ++r)
+		values(r,0) = A(r,r);
+	for(int pass=0; pass < n-1; ++pass){
+		for(int j=0; j < n-1-pass; ++j){
+			lane swap = lanes::greater(values(j,0), values(j+1,0));
+			lane t = values(j,0);
+			values(j,0) = lanes::select(swap, values(j+1,0), t);
+			values(j+1,0) = lanes::select(swap, t, values(j+1,0));
+			if constexpr (withvectors){
+				for(int k=0; k < n; ++k){
+					lane v = V(k,j);
+					V(k,j) = lanes::select(swap, V(k,j+1), v);
+					V(k,j+1) = lanes::select(swap, v, V(k,j+1));
+				}
+			}
+		}
+	}
+}
+
+//the factorisations solve(), solvecholesky() and solveldlt() apply to each batch
+struct TN_LUMethod{
+	template<class lanes, int n, int m>
+	static inline void solve(TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,m> &B,
+							 TN_LaneMatrix<typename lanes::lane,n,m> &X, typename lanes::lane &failed){
+		TN_BatchSolve<lanes>(A, B, X, failed);
+	}
+};
+
+struct TN_CholeskyMethod{
+	template<class lanes, int n, int m>
+	static inline void solve(TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,m> &B,
+							 TN_LaneMatrix<typename lanes::lane,n,m> &X, typename lanes::lane &failed){
+		TN_BatchCholesky<lanes>(A, B, X, failed);
+	}
+};
+
+struct TN_LDLTMethod{
+	template<class lanes, int n, int m>
+	static inline void solve(TN_LaneMatrix<typename lanes::lane,n,n> &A, TN_LaneMatrix<typename lanes::lane,n,m> &B,
+							 TN_LaneMatrix<typename lanes::lane,n,m> &X, typename lanes::lane &failed){
+		TN_BatchLDLT<lanes>(A, B, X, failed);
+	}
+};
+
+//Batches
+//*******
+
+//each batch holds its arrays and computes cells [i,i+count) with packets of width cells
+
+template<class datatype, int n, class allocator, class maskallocator>
+struct TN_InverseBatch{
+
+	typedef datatype celltype;
+	const TN_Array<TN_Matrix<datatype,n,n>, allocator> &m_A;
+	TN_Array<TN_Matrix<datatype,n,n>, allocator> &m_inv;
+	TN_Array<datatype, maskallocator> &m_singular;
+
+	template<int width>
+	inline void apply(TN_Index i, int count) const {
+		typedef TN_Lanes<datatype, width> lanes;
+		TN_LaneMatrix<typename lanes::lane,n,n> A, inv;
+		typename lanes::lane singular;
+		TN_BatchGather<lanes>(m_A, i, count, A);
+		TN_BatchInverse<lanes>(A, inv, singular);
+		TN_BatchScatter<lanes>(inv, i, count, m_inv);
+		TN_BatchScatter<lanes>(singular, i, count, m_singular);
+	}
+};
+
+/*the inverse of one cell at a time by the closed forms of single matrices, which for matrices
+up to 4x4 is faster than gathering them into packets*/
+template<class datatype, int n, class allocator, class maskallocator>
+struct TN_ClosedInverseBatch{
+
+	typedef TN_Matrix<datatype,n,n> celltype;
+	const TN_Array<TN_Matrix<datatype,n,n>, allocator> &m_A;
+	TN_Array<TN_Matrix<datatype,n,n>, allocator> &m_inv;
+	TN_Array<datatype, maskallocator> &m_singular;
+
+	template<int width>
+	inline void apply(TN_Index i, int /*count*/) const {
+		TN_Matrix<datatype,n,n> A, inv;
+		A = m_A(i);
+		m_singular(i) = TN_ClosedInverse(A, inv) ? 0 : 1;
+		m_inv(i) = inv;
+	}
+};
+
+template<class datatype, int n, class allocator, class detallocator>
+struct TN_DeterminantBatch{
+
+	typedef datatype celltype;
+	const TN_Array<TN_Matrix<datatype,n,n>, allocator> &m_A;
+	TN_Array<datatype, detallocator> &m_det;
+
+	template<int width>
+	inline void apply(TN_Index i, int count) const {
+		typedef TN_Lanes<datatype, width> lanes;
+		TN_LaneMatrix<typename lanes::lane,n,n> A;
+		TN_BatchGather<lanes>(m_A, i, count, A);
+		TN_BatchScatter<lanes>(TN_BatchDeterminant<lanes>(A), i, count, m_det);
+	}
+};
+
+template<class method, class datatype, int n, int m, class allocator, class rhsallocator, class maskallocator>
+struct TN_SolveBatch{
+
+	typedef datatype celltype;
+	const TN_Array<TN_Matrix<datatype,n,n>, allocator> &m_A;
+	const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &m_B;
+	TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &m_X;
+	TN_Array<datatype, maskallocator> &m_failed;
+
+	template<int width>
+	inline void apply(TN_Index i, int count) const {
+		typedef TN_Lanes<datatype, width> lanes;
+		TN_LaneMatrix<typename lanes::lane,n,n> A;
+		TN_LaneMatrix<typename lanes::lane,n,m> B, X;
+		typename lanes::lane failed;
+		TN_BatchGather<lanes>(m_A, i, count, A);
+		TN_BatchGather<lanes>(m_B, i, count, B);
+		method::template solve<lanes>(A, B, X, failed);
+		TN_BatchScatter<lanes>(X, i, count, m_X);
+		TN_BatchScatter<lanes>(failed, i, count, m_failed);
+	}
+};
+
+template<class datatype, int n, bool withvectors, class allocator, class valallocator, class vecallocator>
+struct TN_EigenBatch{
+
+	typedef datatype celltype;
+	const TN_Array<TN_Matrix<datatype,n,n>, allocator> &m_A;
+	TN_Array<TN_Matrix<datatype,n,1>, valallocator> &m_values;
+	TN_Array<TN_Matrix<datatype,n,n>, vecallocator> *m_vectors;
+
+	template<int width>
+	inline void apply(TN_Index i, int count) const {
+		typedef TN_Lanes<datatype, width> lanes;
+		TN_LaneMatrix<typename lanes::lane,n,n> A, V;
+		TN_LaneMatrix<typename lanes::lane,n,1> values;
+		TN_BatchGather<lanes>(m_A, i, count, A);
+		TN_BatchJacobi<lanes,n,withvectors>(A, values, V);
+		TN_BatchScatter<lanes>(values, i, count, m_values);
+		if constexpr (withvectors)
+			TN_BatchScatter<lanes>(V, i, count, *m_vectors);
+	}
+};
+
+//Batch kernels
+//*************
+
+//cells [begin,end) of a batch, width at a time
+template<int width, class batch>
+inline void TN_BatchRange(const batch &b, TN_Index begin, TN_Index end){
+	for(TN_Index i=begin; i < end; i += width)
+		b.template apply<width>(i, int(std::min<TN_Index>(width, end - i)));
+};
+
+template<class batch>
+void TN_BatchCells(const batch &b, TN_Index begin, TN_Index end){
+	TN_BatchRange<1>(b, begin, end);
+};
+
+#ifndef TN_NOSIMD
+
+//one kernel per instruction set, as for assignments
+template<class batch>
+__attribute__((flatten))
+void TN_BatchSSE2(const batch &b, TN_Index begin, TN_Index end){
+	TN_BatchRange<16/sizeof(typename batch::celltype)>(b, begin, end);
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+template<class batch>
+__attribute__((target("avx2"), flatten))
+void TN_BatchAVX2(const batch &b, TN_Index begin, TN_Index end){
+	TN_BatchRange<32/sizeof(typename batch::celltype)>(b, begin, end);
+};
+
+template<class batch>
+__attribute__((target("avx512f"), flatten))
+void TN_BatchAVX512(const batch &b, TN_Index begin, TN_Index end){
+	TN_BatchRange<64/sizeof(typename batch::celltype)>(b, begin, end);
+};
+
+#endif
+
+#endif //TN_NOSIMD
+
+template<class batch>
+using TN_BatchKernel = void (*)(const batch &, TN_Index, TN_Index);
+
+//kernel for the current TN_SimdLevel, or a cell at a time for datatypes without packets
+template<class batch>
+inline TN_BatchKernel<batch> TN_BatchPacketKernel(){
+	#ifndef TN_NOSIMD
+		if constexpr (TN_IsPacketType<typename batch::celltype>::value){
+			switch(TN_GetSimdLevel()){
+				#if defined(__x86_64__) || defined(__i386__)
+				case TN_SIMDAVX512:
+					return &TN_BatchAVX512<batch>;
+				case TN_SIMDAVX2:
+					return &TN_BatchAVX2<batch>;
+				#endif
+				case TN_SIMDNONE:
+					break;
+				default:
+					return &TN_BatchSSE2<batch>;
+			}
+		}
+	#endif
+	return &TN_BatchCells<batch>;
+};
+
+//cells of an unpadded array handed to the kernel at a time, a multiple of every packet width
+static constexpr TN_Index TN_BATCHBLOCK = 256;
+
+/*every cell of arrays of nx x ny x nz cells, padded to nzpad, through batch: unpadded arrays in
+blocks of cells and padded arrays a row at a time, in parallel with TN_PARALLELARRAY*/
+template<class batch>
+void TN_BatchArray(const batch &b, TN_Index nx, TN_Index ny, TN_Index nz, TN_Index nzpad){
+	TN_BatchKernel<batch> kernel = TN_BatchPacketKernel<batch>();
+	if(nzpad == nz){
+		TN_Index nt = nx*ny*nz;
+		TN_Index nblocks = (nt + TN_BATCHBLOCK - 1)/TN_BATCHBLOCK;
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index block=0; block < nblocks; ++block){
+			kernel(b, block*TN_BATCHBLOCK, std::min(nt, (block + 1)*TN_BATCHBLOCK));
+		}
+	}
+	else{
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index row=0; row < nx*ny; ++row){
+			kernel(b, row*nzpad, row*nzpad + nz);
+		}
+	}
+};
+
+//arrays of the same size and padding, so that their cells share indices
+template<class A, class B>
+inline void TN_BatchCheckSize(const A &a, const B &b, const char *message){
+	if(a.get_nx() != b.get_nx() || a.get_ny() != b.get_ny() || a.get_nz() != b.get_nz() ||
+	   a.get_nzpad() != b.get_nzpad())
+		throw std::invalid_argument(message);
+};
+
+//arrays a batched function writes, which must also be writable
+template<class A, class B>
+inline void TN_BatchCheckOutput(const A &a, const B &out, const char *message){
+	TN_BatchCheckSize(a, out, message);
+	out.checkwritable();
+};
+
+//Batched functions
+//*****************
+
+/*inv = A^-1 in every cell, with singular 1 in the cells whose matrix has no inverse, whose inv
+is 0, and 0 elsewhere. inv may be A. Only matrices above 4x4 are inverted in packets; up to 4x4
+the closed forms are cheaper per cell than gathering and scattering the packets, so they are
+applied a cell at a time, other than with TN_HEAPMATRIX.*/
+template<class datatype, int n, class allocator, class maskallocator>
+void inverse(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, TN_Array<TN_Matrix<datatype,n,n>, allocator> &inv,
+			 TN_Array<datatype, maskallocator> &singular)
+{
+	static_assert(std::is_floating_point_v<datatype>, "batched inverse() needs matrices of floats or doubles");
+	TN_BatchCheckOutput(A, inv, "inverse: arrays differ in size");
+	TN_BatchCheckOutput(A, singular, "inverse: arrays differ in size");
+	#ifdef TN_HEAPMATRIX
+		constexpr bool closed = false; //matrices on the heap would be allocated for every cell
+	#else
+		constexpr bool closed = n <= 4;
+	#endif
+	if constexpr (closed)
+		TN_BatchArray(TN_ClosedInverseBatch<datatype,n,allocator,maskallocator>{A, inv, singular},
+					  A.get_nx(), A.get_ny(), A.get_nz(), A.get_nzpad());
+	else
+		TN_BatchArray(TN_InverseBatch<datatype,n,allocator,maskallocator>{A, inv, singular},
+					  A.get_nx(), A.get_ny(), A.get_nz(), A.get_nzpad());
+}
+
+//A^-1 in every cell, 0 in cells whose matrix has no inverse
+template<class datatype, int n, class allocator>
+TN_Array<TN_Matrix<datatype,n,n>, allocator> inverse(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A)
+{
+	TN_Array<TN_Matrix<datatype,n,n>, allocator> inv(A.get_nx(), A.get_ny(), A.get_nz());
+	TN_Array<datatype> singular(A.get_nx(), A.get_ny(), A.get_nz());
+	inverse(A, inv, singular);
+	return inv;
+}
+
+//det = the determinant of every cell, which is 0 where it has no inverse
+template<class datatype, int n, class allocator, class detallocator>
+void determinant(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, TN_Array<datatype, detallocator> &det)
+{
+	static_assert(std::is_floating_point_v<datatype>, "batched determinant() needs matrices of floats or doubles");
+	TN_BatchCheckOutput(A, det, "determinant: arrays differ in size");
+	TN_BatchArray(TN_DeterminantBatch<datatype,n,allocator,detallocator>{A, det},
+				  A.get_nx(), A.get_ny(), A.get_nz(), A.get_nzpad());
+}
+
+template<class datatype, int n, class allocator>
+TN_Array<datatype> determinant(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A)
+{
+	TN_Array<datatype> det(A.get_nx(), A.get_ny(), A.get_nz());
+	determinant(A, det);
+	return det;
+}
+
+//X such that AX = B in every cell by method, with failed 1 in the cells it cannot solve
+template<class method, class datatype, int n, int m, class allocator, class rhsallocator, class maskallocator>
+void TN_BatchSolveArrays(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B,
+						 TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &X, TN_Array<datatype, maskallocator> &failed)
+{
+	static_assert(std::is_floating_point_v<datatype>, "batched solves need matrices of floats or doubles");
+	TN_BatchCheckSize(A, B, "solve: arrays differ in size");
+	TN_BatchCheckOutput(A, X, "solve: arrays differ in size");
+	TN_BatchCheckOutput(A, failed, "solve: arrays differ in size");
+	TN_BatchArray(TN_SolveBatch<method,datatype,n,m,allocator,rhsallocator,maskallocator>{A, B, X, failed},
+				  A.get_nx(), A.get_ny(), A.get_nz(), A.get_nzpad());
+}
+
+template<class method, class datatype, int n, int m, class allocator, class rhsallocator>
+TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> TN_BatchSolveArrays(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A,
+																	 const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B)
+{
+	TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> X(A.get_nx(), A.get_ny(), A.get_nz());
+	TN_Array<datatype> failed(A.get_nx(), A.get_ny(), A.get_nz());
+	TN_BatchSolveArrays<method>(A, B, X, failed);
+	return X;
+}
+
+/*X such that AX = B in every cell, with singular 1 in the cells whose A has no inverse, whose
+X is 0, and 0 elsewhere. X may be B.*/
+template<class datatype, int n, int m, class allocator, class rhsallocator, class maskallocator>
+void solve(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B,
+		   TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &X, TN_Array<datatype, maskallocator> &singular)
+{
+	TN_BatchSolveArrays<TN_LUMethod>(A, B, X, singular);
+}
+
+//X such that AX = B in every cell, 0 in cells whose A has no inverse
+template<class datatype, int n, int m, class allocator, class rhsallocator>
+TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> solve(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A,
+													   const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B)
+{
+	return TN_BatchSolveArrays<TN_LUMethod>(A, B);
+}
+
+/*As solve() for symmetric positive-definite A, by Cholesky factorisation of its lower triangle,
+with notpositive 1 in the cells whose A is not positive definite, whose X is 0*/
+template<class datatype, int n, int m, class allocator, class rhsallocator, class maskallocator>
+void solvecholesky(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B,
+				   TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &X, TN_Array<datatype, maskallocator> &notpositive)
+{
+	TN_BatchSolveArrays<TN_CholeskyMethod>(A, B, X, notpositive);
+}
+
+template<class datatype, int n, int m, class allocator, class rhsallocator>
+TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> solvecholesky(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A,
+															   const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B)
+{
+	return TN_BatchSolveArrays<TN_CholeskyMethod>(A, B);
+}
+
+/*As solve() for symmetric A, by LDL^T factorisation of its lower triangle, with singular 1 in
+the cells with a zero pivot, whose X is 0*/
+template<class datatype, int n, int m, class allocator, class rhsallocator, class maskallocator>
+void solveldlt(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B,
+			   TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &X, TN_Array<datatype, maskallocator> &singular)
+{
+	TN_BatchSolveArrays<TN_LDLTMethod>(A, B, X, singular);
+}
+
+template<class datatype, int n, int m, class allocator, class rhsallocator>
+TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> solveldlt(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A,
+														   const TN_Array<TN_Matrix<datatype,n,m>, rhsallocator> &B)
+{
+	return TN_BatchSolveArrays<TN_LDLTMethod>(A, B);
+}
+
+/*The eigenvalues of the symmetric matrix in every cell, read from its lower triangle, ascending
+in values, and its eigenvectors, of unit length, as the columns of vectors in the same order*/
+template<class datatype, int n, class allocator, class valallocator, class vecallocator>
+void eigensymmetric(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, TN_Array<TN_Matrix<datatype,n,1>, valallocator> &values,
+					TN_Array<TN_Matrix<datatype,n,n>, vecallocator> &vectors)
+{
+	static_assert(std::is_floating_point_v<datatype>, "eigensymmetric() needs matrices of floats or doubles");
+	TN_BatchCheckOutput(A, values, "eigensymmetric: arrays differ in size");
+	TN_BatchCheckOutput(A, vectors, "eigensymmetric: arrays differ in size");
+	TN_BatchArray(TN_EigenBatch<datatype,n,true,allocator,valallocator,vecallocator>{A, values, &vectors},
+				  A.get_nx(), A.get_ny(), A.get_nz(), A.get_nzpad());
+}
+
+//the eigenvalues alone, which skips updating the eigenvectors
+template<class datatype, int n, class allocator, class valallocator>
+void eigensymmetric(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A, TN_Array<TN_Matrix<datatype,n,1>, valallocator> &values)
+{
+	static_assert(std::is_floating_point_v<datatype>, "eigensymmetric() needs matrices of floats or doubles");
+	TN_BatchCheckOutput(A, values, "eigensymmetric: arrays differ in size");
+	TN_BatchArray(TN_EigenBatch<datatype,n,false,allocator,valallocator,allocator>{A, values, nullptr},
+				  A.get_nx(), A.get_ny(), A.get_nz(), A.get_nzpad());
+}
+
+template<class datatype, int n, class allocator>
+TN_Array<TN_Matrix<datatype,n,1> > eigensymmetric(const TN_Array<TN_Matrix<datatype,n,n>, allocator> &A)
+{
+	TN_Array<TN_Matrix<datatype,n,1> > values(A.get_nx(), A.get_ny(), A.get_nz());
+	eigensymmetric(A, values);
+	return values;
+}
+
+//the same for a single matrix, a batch of one cell
+template<class datatype, int n>
+void eigensymmetric(const TN_Matrix<datatype,n,n> &A, TN_Matrix<datatype,n,1> &values, TN_Matrix<datatype,n,n> &vectors)
+{
+	static_assert(std::is_floating_point_v<datatype>, "eigensymmetric() needs matrices of floats or doubles");
+	TN_LaneMatrix<datatype,n,n> a, v;
+	TN_LaneMatrix<datatype,n,1> d;
+	for(int c=0; c < n*n; ++c)
+		a.m_v[c] = A(c);
+	TN_BatchJacobi<TN_Lanes<datatype,1>,n,true>(a, d, v);
+	for(int r=0; r < n; ++r)
+		values[r] = d.m_v[r];
+	for(int c=0; c < n*n; ++c)
+		vectors[c] = v.m_v[c];
+}
+
+template<class datatype, int n>
+void eigensymmetric(const TN_Matrix<datatype,n,n> &A, TN_Matrix<datatype,n,1> &values)
+{
+	static_assert(std::is_floating_point_v<datatype>, "eigensymmetric() needs matrices of floats or doubles");
+	TN_LaneMatrix<datatype,n,n> a, v;
+	TN_LaneMatrix<datatype,n,1> d;
+	for(int c=0; c < n*n; ++c)
+		a.m_v[c] = A(c);
+	TN_BatchJacobi<TN_Lanes<datatype,1>,n,false>(a, d, v);
+	for(int r=0; r < n; ++r)
+		values[r] = d.m_v[r];
+}
+
+#endif //TN_BATCHED
@@ -5,153 +5,316 @@ Copyright Ben McLean 2023
 **************************/
 
 #include <memory>
+#include <cstdint>
+#include <type_traits>
 
 #ifndef TN_EXPRTEMP
 #define TN_EXPRTEMP
 
 using namespace std;
 
-#ifdef TN_NOARRAYSOFMATRICES
-
-	/*If no arrays of matrices, MatBinExpr and ArrBinExpr can use references to streamline code,
-	allowing straight-through processing of expressions without the creation of temporaries,
-	meaning memory-use and execution-time is minimised*/
-	template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
-	class MatBinExpr
-	{	
-		protected :
-		const LHS & left_;
-		const RHS & right_;
-		const int nrows_, ncols_;
-		
-   		public :
-		//empty constructor will be optimized away, but triggers
-		//type identification needed for template expansion
-		MatBinExpr(const LHS &leftArg, const RHS &rightArg) : left_(leftArg),
-			right_(rightArg), nrows_(nrows), ncols_(ncols)
-		{};
-		//empty destructor will be optimized away
-		~MatBinExpr(){};
-		
-		//calculate value of expression at specified index by recursing
-		inline RtnType calc(int i) const{
-			return Op::calc(left_, right_, i);
-		};
-		
-		//calculate value of expression at specified index by recursing
-		inline RtnType calc(int row, int col) const{
-			return Op::calc(left_, right_, row*ncols_+col);
-		};
-	};
-
-	template<class LHS, class Op, class RHS, class RtnType>
-	class ArrBinExpr
-	{	
-		protected :
-		const LHS left_;
-		const RHS right_;
-		
-   		public :
-		//empty constructor will be optimized away, but triggers
-		//type identification needed for template expansion
-		ArrBinExpr(const LHS leftArg, const RHS rightArg) : left_(leftArg),
-			right_(rightArg)
-		{};
-		
-		//empty destructor will be optimized away
-		~ArrBinExpr(){};
-		
-		//calculate value of expression at specified index by recursing
-		inline RtnType calc(int i) const{
-			return Op::calc(left_, right_, i);
-		};
-		
-	};
-
-#else //There are arrays of matrices...
-
-	/*If there are arrays of matrices, MatBinExpr and ArrBinExpr must use copy-by-value
-	to prevent dangling pointers. This makes them slower by around 3x, but prevents segfaults.*/
-	template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
-	class MatBinExpr
-	{	
-		protected :
-		const LHS left_;
-		const RHS right_;
-		const int nrows_, ncols_;
-		
-   		public :
-		//empty constructor will be optimized away, but triggers
-		//type identification needed for template expansion
-		MatBinExpr(const LHS leftArg, const RHS rightArg) : left_(leftArg),
-			right_(rightArg), nrows_(nrows), ncols_(ncols)
-		{};
-		//empty destructor will be optimized away
-		~MatBinExpr(){};
-		
-		//calculate value of expression at specified index by recursing
-		inline RtnType calc(int i) const{
-			return Op::calc(left_, right_, i);
-		};
-		
-		//calculate value of expression at specified index by recursing
-		inline RtnType calc(int row, int col) const{
-			return Op::calc(left_, right_, row*ncols_+col);
-		};
-	};
-
-	template<class LHS, class Op, class RHS, class RtnType>
-	class ArrBinExpr
-	{	
-		protected :
-		const LHS left_;
-		const RHS right_;
-		
-   		public :
-		//empty constructor will be optimized away, but triggers
-		//type identification needed for template expansion
-		ArrBinExpr(const LHS leftArg, const RHS rightArg) : left_(leftArg),
-			right_(rightArg)
-		{};
-		
-		//empty destructor will be optimized away
-		~ArrBinExpr(){};
-		
-		//calculate value of expression at specified index by recursing
-		inline RtnType calc(int i) const{
-			return Op::calc(left_, right_, i);
-		};
-		
-	};
-#endif //TN_NOARRAYSOFMATRICES
-
-	/*Note ArrMatBinExpr uses references to streamline code to straight-through processing
-	without the creation of temporaries, meaning memory-use due to the often-large
-	TN_Array<TN_Matrix> > type is minimised.*/
-	template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
-	class ArrMatBinExpr
-	{	
-		protected :
-		const LHS & left_;
-		const RHS & right_;
-		const int nrows_, ncols_;
-		
-   		public :
-		ArrMatBinExpr(const LHS &leftArg, const RHS &rightArg) : left_(leftArg),
-			right_(rightArg), nrows_(nrows), ncols_(ncols)
-		{};
-
-		~ArrMatBinExpr(){};
-		
-		inline RtnType calc(int i) const{
-			return Op::calc(left_, right_, i);
-		};
-
-		inline RtnType calc(int row, int col) const{
-			return Op::calc(left_, right_, row*ncols_+col);
-		};
-		
+/*TN_Index is the type of array sizes and indices, and of the flat index passed to calc().
+It is 64-bit so that arrays, and arrays of matrices counted in scalars, may exceed 2^31 cells.
+#define TN_INDEX32 to use a 32-bit int instead.*/
+#ifdef TN_INDEX32
+	typedef int TN_Index;
+#else
+	typedef std::int64_t TN_Index;
+#endif
+
+template <class datatype, int nrows, int ncols> class TN_Matrix;
+template <class datatype, class allocator> class TN_Array;
+template <class datatype, class allocator> class TN_ArrayView;
+struct MulOp;
+
+/*TN_Operand<T>::type is how an expression node holds an operand of type T. Terminals, i.e.
+matrices and arrays, are held by reference, as they outlive any expression built from them,
+so expressions are evaluated straight through without copying any cells. Everything else is
+held by value: scalars, cheap handles such as views, and the intermediate nodes, which are
+temporaries that may not outlive the calc() that builds them when arrays of matrices are
+evaluated cell by cell. An expression must therefore be assigned in the statement that
+builds it.*/
+template<class T>
+struct TN_Operand{
+	typedef const T type;
+};
+
+template<class datatype, int nrows, int ncols>
+struct TN_Operand<TN_Matrix<datatype, nrows, ncols> >{
+	typedef const TN_Matrix<datatype, nrows, ncols> &type;
+};
+
+template<class datatype, class allocator>
+struct TN_Operand<TN_Array<datatype, allocator> >{
+	typedef const TN_Array<datatype, allocator> &type;
+};
+
+/*An expression aliases its destination if it reads it other than cell by cell, as a matrix
+product does, so that evaluating it straight into the destination would read cells that have
+already been overwritten. TN_Reads(operand, p) is whether an operand reads the object at p at
+all, and TN_Aliases(operand, p) whether it reads it through a matrix product. Terminals are
+compared by address at run time, and only inside products, so for expressions without
+products TN_Aliases is false at compile time. Assignments that alias are evaluated into a
+temporary first.*/
+template<class T>
+inline bool TN_Reads(const T &operand, const void *p);
+
+template<class T>
+inline bool TN_Aliases(const T &operand, const void *p);
+
+//operands whose cells are matrices
+template<class T>
+struct TN_IsMatrixValued : std::false_type {};
+
+//a node of matrix product, rather than of scaling by a scalar
+template<class LHS, class Op, class RHS>
+struct TN_IsProduct : std::bool_constant<std::is_same_v<Op, MulOp> &&
+	TN_IsMatrixValued<LHS>::value && TN_IsMatrixValued<RHS>::value> {};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+class MatBinExpr
+{	
+	protected :
+	typename TN_Operand<LHS>::type left_;
+	typename TN_Operand<RHS>::type right_;
+	const int nrows_, ncols_;
+	
+   	public :
+	//empty constructor will be optimized away, but triggers
+	//type identification needed for template expansion
+	MatBinExpr(const LHS &leftArg, const RHS &rightArg) : left_(leftArg),
+		right_(rightArg), nrows_(nrows), ncols_(ncols)
+	{};
+	//empty destructor will be optimized away
+	~MatBinExpr(){};
+	
+	//calculate value of expression at specified index by recursing
+	inline RtnType calc(TN_Index i) const{
+		return Op::calc(left_, right_, i);
+	};
+	
+	//calculate value of expression at specified index by recursing
+	inline RtnType calc(int row, int col) const{
+		return Op::calc(left_, right_, row*ncols_+col);
+	};
+
+	//operands, for rebuilding the expression, see TN_Plan.h
+	inline const LHS &left() const{
+		return left_;
+	};
+
+	inline const RHS &right() const{
+		return right_;
+	};
+
+	//whether the expression reads the object at p, at all or through a product
+	inline bool reads(const void *p) const{
+		return TN_Reads(left_, p) || TN_Reads(right_, p);
+	};
+
+	inline bool aliases(const void *p) const{
+		if constexpr (TN_IsProduct<LHS, Op, RHS>::value)
+			return reads(p);
+		else
+			return TN_Aliases(left_, p) || TN_Aliases(right_, p);
+	};
+};
+
+template<class LHS, class Op, class RHS, class RtnType>
+class ArrBinExpr
+{	
+	protected :
+	typename TN_Operand<LHS>::type left_;
+	typename TN_Operand<RHS>::type right_;
+	
+   	public :
+	//empty constructor will be optimized away, but triggers
+	//type identification needed for template expansion
+	ArrBinExpr(const LHS &leftArg, const RHS &rightArg) : left_(leftArg),
+		right_(rightArg)
+	{};
+	
+	//empty destructor will be optimized away
+	~ArrBinExpr(){};
+	
+	//calculate value of expression at specified index by recursing
+	inline RtnType calc(TN_Index i) const{
+		return Op::calc(left_, right_, i);
+	};
+
+	//calculate a packet of width cells from the specified index on, see TN_Simd.h
+	template<int width>
+	inline auto calc_packet(TN_Index i) const{
+		return Op::template calc_packet<width>(left_, right_, i);
+	}
+
+	//operands, for finding the arrays an expression reads, see TN_Reduce.h
+	inline const LHS &left() const{
+		return left_;
+	};
+
+	inline const RHS &right() const{
+		return right_;
+	};
+
+	//whether the expression reads the object at p, at all or through a product
+	inline bool reads(const void *p) const{
+		return TN_Reads(left_, p) || TN_Reads(right_, p);
+	};
+
+	inline bool aliases(const void *p) const{
+		if constexpr (TN_IsProduct<LHS, Op, RHS>::value)
+			return reads(p);
+		else
+			return TN_Aliases(left_, p) || TN_Aliases(right_, p);
+	};
+	
+};
+
+/*TN_IsOutOfCore<expr>::value is true for arrays whose cells are not all in memory, such
+as TN_TiledArray, and for expressions that read them. Array assignment evaluates such
+expressions a plane at a time, so that the tiles each plane reads are loaded beforehand.*/
+template<class T>
+struct TN_IsOutOfCore : std::false_type {};
+
+template<class LHS, class Op, class RHS, class RtnType>
+struct TN_IsOutOfCore<ArrBinExpr<LHS, Op, RHS, RtnType> > :
+	std::bool_constant<TN_IsOutOfCore<LHS>::value || TN_IsOutOfCore<RHS>::value> {};
+
+/*ArrMatBinExpr holds its operands as the other nodes do, so the often-large
+TN_Array<TN_Matrix<> > terminals are read in place, without the creation of temporaries.*/
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+class ArrMatBinExpr
+{	
+	protected :
+	typename TN_Operand<LHS>::type left_;
+	typename TN_Operand<RHS>::type right_;
+	const int nrows_, ncols_;
+	
+   	public :
+	ArrMatBinExpr(const LHS &leftArg, const RHS &rightArg) : left_(leftArg),
+		right_(rightArg), nrows_(nrows), ncols_(ncols)
+	{};
+
+	~ArrMatBinExpr(){};
+	
+	/*calc returns whatever matrix expression Op builds for the cell; RtnType names it for
+	overload matching, but with TN_SOAARRAYSOFMATRICES the cells are plane proxies instead*/
+	inline auto calc(TN_Index i) const{
+		return Op::calc(left_, right_, i);
+	};
+
+	inline auto calc(int row, int col) const{
+		return Op::calc(left_, right_, row*ncols_+col);
+	};
+
+	//operands, for finding the arrays an expression reads, see TN_Reduce.h
+	inline const LHS &left() const{
+		return left_;
+	};
+
+	inline const RHS &right() const{
+		return right_;
+	};
+
+	//whether the expression reads the object at p, at all or through a product
+	inline bool reads(const void *p) const{
+		return TN_Reads(left_, p) || TN_Reads(right_, p);
+	};
+
+	inline bool aliases(const void *p) const{
+		if constexpr (TN_IsProduct<LHS, Op, RHS>::value)
+			return reads(p);
+		else
+			return TN_Aliases(left_, p) || TN_Aliases(right_, p);
 	};
+	
+};
+
+/*TN_IsArrayExpr<T>::value is true for arrays and array expressions, whose calc(i) gives cell i,
+and false for scalars, matrices and matrix expressions, which are the same in every cell.*/
+template<class T>
+struct TN_IsArrayExpr : std::false_type {};
+
+template<class datatype, class allocator>
+struct TN_IsArrayExpr<TN_Array<datatype, allocator> > : std::true_type {};
+
+template<class LHS, class Op, class RHS, class RtnType>
+struct TN_IsArrayExpr<ArrBinExpr<LHS, Op, RHS, RtnType> > : std::true_type {};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+struct TN_IsArrayExpr<ArrMatBinExpr<LHS, Op, RHS, nrows, ncols, RtnType> > : std::true_type {};
+
+/*TN_ArrayOperand<T> is the TN_Array<datatype, allocator> that T derives from, e.g. for a
+TN_MappedArray, or likewise the TN_ArrayView, e.g. for a TN_ConstArrayView, and T itself for
+everything else, so that functions which deduce their operands' types take derived arrays and
+views, of any allocation policy, as the arrays and views they are.*/
+template<class T>
+struct TN_ArrayBase{
+	template<class datatype, class allocator>
+	static const TN_Array<datatype, allocator> *base(const TN_Array<datatype, allocator> *);
+	template<class datatype, class allocator>
+	static const TN_ArrayView<datatype, allocator> *base(const TN_ArrayView<datatype, allocator> *);
+	static const T *base(...);
+	typedef std::remove_const_t<std::remove_pointer_t<decltype(base(static_cast<const T *>(nullptr)))> > type;
+};
+
+template<class T>
+using TN_ArrayOperand = typename TN_ArrayBase<T>::type;
+
+//whether T derives from a TN_Array without being one
+template<class T>
+struct TN_IsDerivedArray : std::bool_constant<!std::is_same_v<TN_ArrayOperand<T>, T> > {};
+
+/*TN_HasExtent<T>::value is true for operands with cells to read one by one: arrays, including
+arrays derived from TN_Array such as TN_MappedArray, views, tiled arrays and array expressions,
+whose size e.g. a reduction takes from the first array they read. Scalars, matrices and matrix
+expressions are the same for every cell.*/
+template<class T>
+struct TN_HasExtent : TN_IsArrayExpr<TN_ArrayOperand<T> > {};
+
+template<class datatype, int nrows, int ncols>
+struct TN_IsMatrixValued<TN_Matrix<datatype, nrows, ncols> > : std::true_type {};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+struct TN_IsMatrixValued<MatBinExpr<LHS, Op, RHS, nrows, ncols, RtnType> > : std::true_type {};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+struct TN_IsMatrixValued<ArrMatBinExpr<LHS, Op, RHS, nrows, ncols, RtnType> > : std::true_type {};
+
+template<class datatype, int nrows, int ncols, class allocator>
+struct TN_IsMatrixValued<TN_Array<TN_Matrix<datatype, nrows, ncols>, allocator> > : std::true_type {};
+
+//expression nodes, as opposed to terminals and scalars
+template<class T>
+struct TN_IsExprNode : std::false_type {};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+struct TN_IsExprNode<MatBinExpr<LHS, Op, RHS, nrows, ncols, RtnType> > : std::true_type {};
+
+template<class LHS, class Op, class RHS, class RtnType>
+struct TN_IsExprNode<ArrBinExpr<LHS, Op, RHS, RtnType> > : std::true_type {};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+struct TN_IsExprNode<ArrMatBinExpr<LHS, Op, RHS, nrows, ncols, RtnType> > : std::true_type {};
+
+template<class T>
+inline bool TN_Reads(const T &operand, const void *p){
+	if constexpr (TN_IsExprNode<T>::value)
+		return operand.reads(p);
+	else if constexpr (std::is_arithmetic_v<T>)
+		return false;
+	else
+		return static_cast<const void *>(&operand) == p;
+}
+
+template<class T>
+inline bool TN_Aliases(const T &operand, const void *p){
+	if constexpr (TN_IsExprNode<T>::value)
+		return operand.aliases(p);
+	else
+		return false;
+}
 
 #endif //TN_EXPRTEMP
 
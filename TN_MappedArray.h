@@ -0,0 +1,167 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//********************
+//class TN_MappedArray
+//********************
+//a TN_Array whose data is a file mapped into memory, rather than read into an allocation.
+
+#ifndef TN_MAPPEDARRAY
+#define TN_MAPPEDARRAY
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <string>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+//mapping modes
+enum TN_MapMode{
+	TN_MAPREADONLY,		//shared read-only pages; the array must not be written
+	TN_MAPCOPYONWRITE	//private pages, copied on first write; the file is never modified
+};
+
+//access hints, which may be combined, e.g. TN_ADVISESEQUENTIAL | TN_ADVISEWILLNEED
+enum TN_MapAdvice{
+	TN_ADVISENORMAL = 0,
+	TN_ADVISESEQUENTIAL = 1,	//read ahead aggressively, drop pages soon after use
+	TN_ADVISERANDOM = 2,		//do not read ahead
+	TN_ADVISEWILLNEED = 4,		//start reading the whole array into the page cache now
+	TN_ADVISEHUGEPAGE = 8		//back the mapping with huge pages where the kernel can (Linux)
+};
+
+/*The file holds the nx*ny*nz cells of the array in (i,j,k) order, as raw datatype values,
+starting offset bytes into the file. Nothing is read at construction: pages are read from the
+page cache on first access, and read-only mappings of the same file by several processes
+share the same physical pages. A TN_MappedArray is a TN_Array<datatype>, so it can be used in
+expressions as any other array. Since the file has no row padding, nz must be a multiple of
+TN_PADCELLS, and data is 64-byte aligned when offset is a multiple of 64.
+Mapped arrays cannot be copied, resized or swapped, and moving one into a TN_Array copies its
+cells. With TN_MAPREADONLY the array is not writable: every assignment to it, or to a view of
+it, and every tie() or batched function writing it, throws std::logic_error, also through a
+reference to TN_Array. Its cells must only be indexed through const references, as writes
+through (i,j,k) or data() fault on its read-only pages.*/
+template <class datatype>
+class TN_MappedArray : public TN_Array<datatype> {
+
+	static_assert(std::is_arithmetic_v<datatype>, "TN_MappedArray holds arrays of scalars");
+
+	protected:
+
+	void *m_map = nullptr; //start of the mapping, at a page boundary
+	size_t m_maplength = 0; //length of the mapping in bytes
+
+	private:
+
+	void map(const std::string &filename, TN_MapMode mode, off_t offset){
+		if(this->m_nzpad != this->m_nz)
+			throw std::invalid_argument("TN_MappedArray: nz must be a multiple of TN_PADCELLS");
+
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if(fd < 0)
+			throw std::system_error(errno, std::generic_category(), "TN_MappedArray: " + filename);
+
+		size_t bytes = size_t(this->m_nt)*sizeof(datatype);
+		struct stat st;
+		if(::fstat(fd, &st) != 0 || off_t(offset + bytes) > st.st_size){
+			::close(fd);
+			throw std::runtime_error("TN_MappedArray: " + filename + " is smaller than the array");
+		}
+
+		//mappings start at a page boundary, so map from the page holding offset
+		off_t pagestart = offset - offset % ::sysconf(_SC_PAGESIZE);
+		m_maplength = bytes + size_t(offset - pagestart);
+		if(mode == TN_MAPREADONLY)
+			m_map = ::mmap(nullptr, m_maplength, PROT_READ, MAP_SHARED, fd, pagestart);
+		else
+			m_map = ::mmap(nullptr, m_maplength, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, pagestart);
+		int error = errno;
+		::close(fd); //the mapping keeps the file open
+		if(m_map == MAP_FAILED){
+			m_map = nullptr;
+			throw std::system_error(error, std::generic_category(), "TN_MappedArray: mmap " + filename);
+		}
+		this->m_data = reinterpret_cast<datatype *>(static_cast<char *>(m_map) + (offset - pagestart));
+	};
+
+	void unmap(){
+		if(m_map){
+			::munmap(m_map, m_maplength);
+			m_map = nullptr;
+		}
+		this->m_data = nullptr;
+	};
+
+	public:
+
+	TN_MappedArray(const std::string &filename, TN_Index nx, TN_Index ny, TN_Index nz,
+			TN_MapMode mode = TN_MAPREADONLY, int advice = TN_ADVISENORMAL, off_t offset = 0,
+			double dx = 1.0, double dy = 1.0, double dz = 1.0,
+			double ox = 0.0, double oy = 0.0, double oz = 0.0) :
+		TN_Array<datatype>(nx, ny, nz, dx, dy, dz, ox, oy, oz, nullptr, mode != TN_MAPREADONLY){
+		map(filename, mode, offset);
+		advise(advice);
+	};
+
+	virtual ~TN_MappedArray(){
+		unmap();
+	};
+
+	TN_MappedArray(const TN_MappedArray &) = delete;
+
+	template<class... args>
+	void resize(args...) = delete;
+
+	void swap(TN_Array<datatype> &) = delete;
+
+	/*give the kernel access hints for the mapping, as a combination of TN_MapAdvice values.
+	Hints are advisory, so those the kernel does not support are ignored.*/
+	void advise(int advice){
+		if(!m_map)
+			return;
+		if(advice & TN_ADVISESEQUENTIAL)
+			::madvise(m_map, m_maplength, MADV_SEQUENTIAL);
+		if(advice & TN_ADVISERANDOM)
+			::madvise(m_map, m_maplength, MADV_RANDOM);
+		if(advice & TN_ADVISEWILLNEED)
+			::madvise(m_map, m_maplength, MADV_WILLNEED);
+		#ifdef MADV_HUGEPAGE
+			if(advice & TN_ADVISEHUGEPAGE)
+				::madvise(m_map, m_maplength, MADV_HUGEPAGE);
+		#endif
+	};
+
+	//Array = Array, copies the cells, copy-on-write mappings only
+	TN_MappedArray &operator = (const TN_MappedArray &array){
+		this->checkwritable();
+		if(this != &array)
+			TN_Array<datatype>::template operator=<TN_Array<datatype> >(array);
+		return *this;
+	};
+
+	//Array = double or int etc, copy-on-write mappings only
+	TN_MappedArray &operator = (const datatype &value){
+		TN_Array<datatype>::operator=(value);
+		return *this;
+	};
+
+	//Array = expression, copy-on-write mappings only
+	template<typename expr>
+	TN_MappedArray &operator = (const expr &expression){
+		TN_Array<datatype>::template operator=<expr>(expression);
+		return *this;
+	}
+};
+
+#endif //unix
+
+#endif //TN_MAPPEDARRAY
@@ -13,20 +13,70 @@ TUNGSTEN Arrays of matrices
 #define TN_MATRIX
 
 #include <vector>
+#include <cstddef>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
 
 using namespace std;
 
+//alignment of inline matrix storage: the largest power of two, up to a 64-byte
+//cache line, that divides the matrix size in bytes. Matrices are therefore aligned
+//for SIMD loads without padding, so arrays of matrices stay densely packed.
+template<class datatype, int ncells>
+constexpr size_t TN_MatrixAlign(){
+	size_t bytes = sizeof(datatype)*ncells;
+	size_t align = 64;
+	while(align > alignof(datatype) && bytes % align != 0)
+		align /= 2;
+	return align;
+}
+
 template <class datatype, int nrows, int ncols> class TN_Matrix{
 
 	protected:
 	
-	int m_nrows, m_ncols; //matrix size
-	int m_nt; //total number of cells
-	vector<datatype> m_data; //matrix cell data
+	static constexpr int m_nrows = nrows, m_ncols = ncols; //matrix size
+	static constexpr int m_nt = nrows*ncols; //total number of cells
+	#ifdef TN_HEAPMATRIX
+		//matrix cell data, on the heap, or in the thread's arena inside a TN_ArenaScope
+		vector<datatype, TN_AlignedAllocator<datatype, TN_MatrixAlign<datatype,nrows*ncols>(), 1> > m_data =
+			vector<datatype, TN_AlignedAllocator<datatype, TN_MatrixAlign<datatype,nrows*ncols>(), 1> >(nrows*ncols);
+	#else
+		alignas(TN_MatrixAlign<datatype,nrows*ncols>()) datatype m_data[nrows*ncols]; //matrix cell data, inline
+	#endif
 	
 	
 	private:
 	
+	//cell = f(cell, value) for every cell of an expression
+	template<class expr, class func>
+	inline void updatecells(const expr &expression, func f){
+		#ifdef TN_PARALLELMATRIX
+			#pragma omp parallel for
+		#endif
+		for(int i=0;i < m_nt;++i){
+			f(m_data[i], expression.calc(i));
+		}
+	}
+
+	/*updatecells, once any nested products the expression would recompute for every cell are
+	materialised into scratch matrices, see TN_Plan.h*/
+	template<class expr, class func>
+	TN_Matrix &evaluate(const expr &expression, func f){
+		if constexpr (TN_IsPlanned<expr>::value){
+			#ifdef TN_HEAPMATRIX
+				TN_ArenaScope scope;
+			#endif
+			TN_Plan<expr, 1, TN_SCRATCHBYTES>::apply(expression, [&](const auto &planned){
+				updatecells(planned, f);
+			});
+		}else{
+			updatecells(expression, f);
+		}
+		return *this;
+	}
 	
 	public:
 	
@@ -34,7 +84,7 @@ template <class datatype, int nrows, int ncols> class TN_Matrix{
 	//************
 	
 	//constructor
-	TN_Matrix() : m_nrows(nrows), m_ncols(ncols), m_nt(nrows*ncols), m_data(nrows*ncols){
+	TN_Matrix(){
 		#ifdef TN_INITIALIZE
 			for(int i=0;i<m_nt;++i)
 				m_data[i] = 0;
@@ -42,9 +92,19 @@ template <class datatype, int nrows, int ncols> class TN_Matrix{
 	};
 	
 	//destructor
-	~TN_Matrix(){};
+	~TN_Matrix() = default;
 
-	//default copy constructor etc
+	//default copy and move, a plain copy of the cells when stored inline
+	TN_Matrix(const TN_Matrix &) = default;
+	#ifdef TN_HEAPMATRIX
+		//takes the cells only if they come from the TN_ArenaScope active here, otherwise copies them
+		TN_Matrix(TN_Matrix &&matrix) : m_data(std::move(matrix.m_data), typename decltype(m_data)::allocator_type())
+		{};
+	#else
+		TN_Matrix(TN_Matrix &&) = default;
+	#endif
+	TN_Matrix &operator=(const TN_Matrix &) = default;
+	TN_Matrix &operator=(TN_Matrix &&) = default;
 
 	//structure-fetching functions
 	//****************************
@@ -129,19 +189,142 @@ template <class datatype, int nrows, int ncols> class TN_Matrix{
 		return *this;
 	}
 
-	//assignment by expression (use of nrows,ncols forces compile-time compatability)
+	/*assignment by expression (use of nrows,ncols forces compile-time compatability). A product
+	that reads this matrix, e.g. m = m * n, is evaluated into a temporary first; all other
+	expressions are evaluated straight through, apart from any nested products they would
+	recompute for every cell.*/
 	template<class LHS, class Op, class RHS, class RtnType>
     TN_Matrix<datatype,nrows,ncols> &operator=(const MatBinExpr<LHS,Op,RHS,nrows,ncols,RtnType> &expression){
-    
+
+		if(expression.aliases(this)){
+			TN_Matrix temp;
+			temp = expression;
+			return *this = temp;
+		}
+		return evaluate(expression, [](datatype &cell, const datatype &value){ cell = value; });
+	}
+
+	//Compound assignment
+	//*******************
+
+	//Matrix += datatype, matrix or expression, cell by cell, or via a temporary if it aliases
+	TN_Matrix &operator+=(const datatype &val){
 		#ifdef TN_PARALLELMATRIX
 			#pragma omp parallel for
 		#endif
 		for(int i=0;i < m_nt;++i){
-			m_data[i] = expression.calc(i);
+			m_data[i] += val;
 		}
 		return *this;
+	};
+
+	TN_Matrix &operator+=(const TN_Matrix &m){
+		#ifdef TN_PARALLELMATRIX
+			#pragma omp parallel for
+		#endif
+		for(int i=0;i < m_nt;++i){
+			m_data[i] += m[i];
+		}
+		return *this;
+	};
+
+	template<class LHS, class Op, class RHS, class RtnType>
+	TN_Matrix &operator+=(const MatBinExpr<LHS,Op,RHS,nrows,ncols,RtnType> &expression){
+		if(expression.aliases(this)){
+			TN_Matrix temp;
+			temp = expression;
+			return *this += temp;
+		}
+		return evaluate(expression, [](datatype &cell, const datatype &value){ cell += value; });
 	}
-	
+
+	//Matrix -= datatype, matrix or expression, cell by cell, or via a temporary if it aliases
+	TN_Matrix &operator-=(const datatype &val){
+		#ifdef TN_PARALLELMATRIX
+			#pragma omp parallel for
+		#endif
+		for(int i=0;i < m_nt;++i){
+			m_data[i] -= val;
+		}
+		return *this;
+	};
+
+	TN_Matrix &operator-=(const TN_Matrix &m){
+		#ifdef TN_PARALLELMATRIX
+			#pragma omp parallel for
+		#endif
+		for(int i=0;i < m_nt;++i){
+			m_data[i] -= m[i];
+		}
+		return *this;
+	};
+
+	template<class LHS, class Op, class RHS, class RtnType>
+	TN_Matrix &operator-=(const MatBinExpr<LHS,Op,RHS,nrows,ncols,RtnType> &expression){
+		if(expression.aliases(this)){
+			TN_Matrix temp;
+			temp = expression;
+			return *this -= temp;
+		}
+		return evaluate(expression, [](datatype &cell, const datatype &value){ cell -= value; });
+	}
+
+	//Matrix *= and /= datatype
+	TN_Matrix &operator*=(const datatype &val){
+		#ifdef TN_PARALLELMATRIX
+			#pragma omp parallel for
+		#endif
+		for(int i=0;i < m_nt;++i){
+			m_data[i] *= val;
+		}
+		return *this;
+	};
+
+	TN_Matrix &operator/=(const datatype &val){
+		#ifdef TN_PARALLELMATRIX
+			#pragma omp parallel for
+		#endif
+		for(int i=0;i < m_nt;++i){
+			m_data[i] /= val;
+		}
+		return *this;
+	};
+
+	/*Matrix *= square matrix, the matrix product, as for operator*. Each row of the product
+	only reads the same row of this matrix, so rows are computed into a buffer one at a time
+	and copied back. An expression is evaluated into a matrix first, as each of its cells is
+	read once per row.*/
+	TN_Matrix &operator*=(const TN_Matrix<datatype,ncols,ncols> &m){
+		if(static_cast<const void *>(&m) == static_cast<const void *>(this)){
+			TN_Matrix<datatype,ncols,ncols> copy(m);
+			return *this *= copy;
+		}
+		#ifdef TN_PARALLELMATRIX
+			#pragma omp parallel for
+		#endif
+		for(int row=0;row < nrows;++row){
+			datatype product[ncols];
+			for(int col=0;col < ncols;++col){
+				datatype val = 0.0;
+				for(int k=0;k < ncols;++k){
+					val += m_data[row*ncols+k]*m(k,col);
+				}
+				product[col] = val;
+			}
+			for(int col=0;col < ncols;++col){
+				m_data[row*ncols+col] = product[col];
+			}
+		}
+		return *this;
+	};
+
+	template<class LHS, class Op, class RHS, class RtnType>
+	TN_Matrix &operator*=(const MatBinExpr<LHS,Op,RHS,ncols,ncols,RtnType> &expression){
+		TN_Matrix<datatype,ncols,ncols> m;
+		m = expression;
+		return *this *= m;
+	}
+
 	//Matrix.set(set, of, comma, separated, values)
 	void set(
 	const datatype v00=0, const datatype v01=0, const datatype v02=0,
@@ -202,7 +385,7 @@ template <class datatype, int nrows, int ncols> class TN_Matrix{
         return unequalmatrices;
 	};
 
-	bool operator < (const TN_Matrix<datatype, nrows, ncols> &m){
+	bool operator < (const TN_Matrix<datatype, nrows, ncols> &m) const {
 		datatype thismin = this->min();
 		datatype thatmin = m.min();
 		if(thismin < thatmin)
@@ -211,7 +394,7 @@ template <class datatype, int nrows, int ncols> class TN_Matrix{
 			return false;
 	};
 
-	bool operator > (const TN_Matrix<datatype, nrows, ncols> &m){
+	bool operator > (const TN_Matrix<datatype, nrows, ncols> &m) const {
 		datatype thismax = this->max();
 		datatype thatmax = m.max();
 		if(thismax > thatmax)
@@ -224,7 +407,7 @@ template <class datatype, int nrows, int ncols> class TN_Matrix{
 	//**************************
 	
 	//calc(index) for templated expressions
-	inline const datatype & calc(int i) const{
+	inline const datatype & calc(TN_Index i) const{
 		return m_data[i];
 	};
 	
@@ -288,6 +471,347 @@ TN_Matrix<datatype,ncols,nrows> transpose(const TN_Matrix<datatype,nrows,ncols>
 	return t;
 };
 
+//LU factorisation
+//****************
+
+/*LU factorisation with partial pivoting of an n x n matrix, PA = LU, held in plain arrays
+inside the object, so that factorising, and the determinant, inverse and solve built on it,
+make no allocations, even with TN_HEAPMATRIX. It is O(n^3), where cofactor expansion is O(n!).
+For floating-point datatypes; determinant() and inverse() keep cofactor expansion for others,
+as it is exact for integers. solve() and inverse() of a singular matrix, one with a column
+without a pivot, throw std::domain_error rather than giving infinities or NaNs; singular()
+tells beforehand.*/
+template<class datatype, int n>
+class TN_LU{
+
+	protected:
+
+	datatype m_lu[n*n]; //L below the diagonal, whose own diagonal is 1, and U on and above it
+	int m_perm[n]; //row of A in each row of the factorisation
+	int m_sign; //sign of the permutation, for the determinant
+	bool m_singular; //whether a column had no pivot
+
+	public:
+
+	TN_LU(const TN_Matrix<datatype,n,n> &A) : m_sign(1), m_singular(false){
+		for(int i=0; i < n*n; ++i)
+			m_lu[i] = A(i);
+		for(int r=0; r < n; ++r)
+			m_perm[r] = r;
+
+		for(int c=0; c < n; ++c){
+			//pivot on the largest remaining cell of the column
+			int p = c;
+			datatype largest = std::abs(m_lu[c*n+c]);
+			for(int r=c+1; r < n; ++r){
+				if(std::abs(m_lu[r*n+c]) > largest){
+					largest = std::abs(m_lu[r*n+c]);
+					p = r;
+				}
+			}
+			if(largest == 0){
+				m_singular = true;
+				continue;
+			}
+			if(p != c){
+				for(int k=0; k < n; ++k)
+					std::swap(m_lu[p*n+k], m_lu[c*n+k]);
+				std::swap(m_perm[p], m_perm[c]);
+				m_sign = -m_sign;
+			}
+
+			//eliminate the column below the pivot
+			for(int r=c+1; r < n; ++r){
+				datatype l = m_lu[r*n+c] /= m_lu[c*n+c];
+				for(int k=c+1; k < n; ++k)
+					m_lu[r*n+k] -= l*m_lu[c*n+k];
+			}
+		}
+	};
+
+	//whether A is singular, i.e. has no inverse
+	inline bool singular() const{
+		return m_singular;
+	};
+
+	void checksingular(const char *message) const{
+		if(m_singular)
+			throw std::domain_error(message);
+	};
+
+	inline datatype determinant() const{
+		datatype det = m_sign;
+		for(int c=0; c < n; ++c)
+			det *= m_lu[c*n+c];
+		return det;
+	};
+
+	//X such that AX = B, a column of B at a time
+	template<int m>
+	TN_Matrix<datatype,n,m> solve(const TN_Matrix<datatype,n,m> &B) const{
+		checksingular("TN_LU::solve: singular matrix");
+		TN_Matrix<datatype,n,m> X;
+		for(int j=0; j < m; ++j){
+			//forward substitution through L, with B's rows permuted as A's were
+			for(int r=0; r < n; ++r){
+				datatype y = B(m_perm[r], j);
+				for(int k=0; k < r; ++k)
+					y -= m_lu[r*n+k]*X(k,j);
+				X(r,j) = y;
+			}
+			//back substitution through U
+			for(int r=n-1; r >= 0; --r){
+				datatype x = X(r,j);
+				for(int k=r+1; k < n; ++k)
+					x -= m_lu[r*n+k]*X(k,j);
+				X(r,j) = x/m_lu[r*n+r];
+			}
+		}
+		return X;
+	}
+
+	//A^-1, solving against the identity
+	TN_Matrix<datatype,n,n> inverse() const{
+		checksingular("TN_LU::inverse: singular matrix");
+		TN_Matrix<datatype,n,n> X;
+		for(int j=0; j < n; ++j){
+			for(int r=0; r < n; ++r){
+				datatype y = (m_perm[r] == j) ? 1 : 0;
+				for(int k=0; k < r; ++k)
+					y -= m_lu[r*n+k]*X(k,j);
+				X(r,j) = y;
+			}
+			for(int r=n-1; r >= 0; --r){
+				datatype x = X(r,j);
+				for(int k=r+1; k < n; ++k)
+					x -= m_lu[r*n+k]*X(k,j);
+				X(r,j) = x/m_lu[r*n+r];
+			}
+		}
+		return X;
+	};
+};
+
+//X such that AX = B, for floating-point datatypes; throws std::domain_error if A is singular
+template<class datatype, int n, int m>
+TN_Matrix<datatype,n,m> solve(const TN_Matrix<datatype,n,n> &A, const TN_Matrix<datatype,n,m> &B)
+{
+	return TN_LU<datatype,n>(A).solve(B);
+}
+
+//Cholesky and LDLT factorisation
+//*******************************
+
+/*Factorisations of symmetric matrices, e.g. stiffness and covariance matrices, read from the
+lower triangle of A alone. They need no pivoting and take about half the work of TN_LU, and
+like it are held in plain arrays and make no allocations. TN_Cholesky, A = LL^T, is for
+positive-definite matrices. TN_LDLT, A = LDL^T with L unit lower triangular and D diagonal,
+needs no square roots and also factorises symmetric matrices that are not positive definite,
+though without pivoting it is only stable for those that are, or are diagonally dominant.*/
+template<class datatype, int n>
+class TN_Cholesky{
+
+	protected:
+
+	datatype m_l[n*n]; //L on and below the diagonal
+	datatype m_rdiag[n]; //reciprocals of L's diagonal
+	bool m_positive; //whether every pivot was positive
+
+	//X such that AX = B, with B's cells given by b(row,col), through L and then L^T
+	template<int m, class rhs>
+	void substitute(TN_Matrix<datatype,n,m> &X, rhs b) const{
+		for(int j=0; j < m; ++j){
+			for(int r=0; r < n; ++r){
+				datatype y = b(r,j);
+				for(int k=0; k < r; ++k)
+					y -= m_l[r*n+k]*X(k,j);
+				X(r,j) = y*m_rdiag[r];
+			}
+			for(int r=n-1; r >= 0; --r){
+				datatype x = X(r,j);
+				for(int k=r+1; k < n; ++k)
+					x -= m_l[k*n+r]*X(k,j);
+				X(r,j) = x*m_rdiag[r];
+			}
+		}
+	}
+
+	public:
+
+	TN_Cholesky(const TN_Matrix<datatype,n,n> &A) : m_positive(true){
+		for(int j=0; j < n; ++j){
+			datatype d = A(j,j);
+			for(int k=0; k < j; ++k)
+				d -= m_l[j*n+k]*m_l[j*n+k];
+			//a pivot that is not positive is taken as 1, so that the factor stays finite
+			if(!(d > 0)){
+				m_positive = false;
+				d = 1;
+			}
+			m_l[j*n+j] = std::sqrt(d);
+			m_rdiag[j] = 1/m_l[j*n+j];
+			for(int r=j+1; r < n; ++r){
+				datatype x = A(r,j);
+				for(int k=0; k < j; ++k)
+					x -= m_l[r*n+k]*m_l[j*n+k];
+				m_l[r*n+j] = x*m_rdiag[j];
+			}
+		}
+	};
+
+	//whether A is positive definite; if not, the results below are meaningless
+	inline bool positivedefinite() const{
+		return m_positive;
+	};
+
+	inline datatype determinant() const{
+		datatype det = 1;
+		for(int c=0; c < n; ++c)
+			det *= m_l[c*n+c];
+		return det*det;
+	};
+
+	//the factor L, lower triangular
+	TN_Matrix<datatype,n,n> L() const{
+		TN_Matrix<datatype,n,n> l;
+		for(int r=0; r < n; ++r)
+			for(int c=0; c < n; ++c)
+				l(r,c) = (c <= r) ? m_l[r*n+c] : 0;
+		return l;
+	};
+
+	//X such that AX = B
+	template<int m>
+	TN_Matrix<datatype,n,m> solve(const TN_Matrix<datatype,n,m> &B) const{
+		TN_Matrix<datatype,n,m> X;
+		substitute(X, [&B](int r, int c){ return B(r,c); });
+		return X;
+	}
+
+	//A^-1, solving against the identity
+	TN_Matrix<datatype,n,n> inverse() const{
+		TN_Matrix<datatype,n,n> X;
+		substitute(X, [](int r, int c){ return datatype((r == c) ? 1 : 0); });
+		return X;
+	};
+};
+
+template<class datatype, int n>
+class TN_LDLT{
+
+	protected:
+
+	datatype m_ld[n*n]; //D on the diagonal, and L, whose own diagonal is 1, below it
+	datatype m_rd[n]; //reciprocals of D
+	bool m_singular; //whether a pivot was 0
+
+	//X such that AX = B, with B's cells given by b(row,col), through L, D and then L^T
+	template<int m, class rhs>
+	void substitute(TN_Matrix<datatype,n,m> &X, rhs b) const{
+		for(int j=0; j < m; ++j){
+			for(int r=0; r < n; ++r){
+				datatype y = b(r,j);
+				for(int k=0; k < r; ++k)
+					y -= m_ld[r*n+k]*X(k,j);
+				X(r,j) = y;
+			}
+			for(int r=n-1; r >= 0; --r){
+				datatype x = X(r,j)*m_rd[r];
+				for(int k=r+1; k < n; ++k)
+					x -= m_ld[k*n+r]*X(k,j);
+				X(r,j) = x;
+			}
+		}
+	}
+
+	public:
+
+	TN_LDLT(const TN_Matrix<datatype,n,n> &A) : m_singular(false){
+		datatype v[n]; //row j of L times D
+		for(int j=0; j < n; ++j){
+			datatype d = A(j,j);
+			for(int k=0; k < j; ++k){
+				v[k] = m_ld[j*n+k]*m_ld[k*n+k];
+				d -= m_ld[j*n+k]*v[k];
+			}
+			//a zero pivot is taken as 1, so that the factor stays finite
+			if(d == 0){
+				m_singular = true;
+				d = 1;
+			}
+			m_ld[j*n+j] = d;
+			m_rd[j] = 1/d;
+			for(int r=j+1; r < n; ++r){
+				datatype x = A(r,j);
+				for(int k=0; k < j; ++k)
+					x -= m_ld[r*n+k]*v[k];
+				m_ld[r*n+j] = x*m_rd[j];
+			}
+		}
+	};
+
+	//whether A is singular; if so, the results below are meaningless
+	inline bool singular() const{
+		return m_singular;
+	};
+
+	inline datatype determinant() const{
+		datatype det = 1;
+		for(int c=0; c < n; ++c)
+			det *= m_ld[c*n+c];
+		return det;
+	};
+
+	//the factor L, unit lower triangular
+	TN_Matrix<datatype,n,n> L() const{
+		TN_Matrix<datatype,n,n> l;
+		for(int r=0; r < n; ++r)
+			for(int c=0; c < n; ++c)
+				l(r,c) = (c < r) ? m_ld[r*n+c] : datatype((c == r) ? 1 : 0);
+		return l;
+	};
+
+	//the diagonal of D
+	TN_Matrix<datatype,n,1> D() const{
+		TN_Matrix<datatype,n,1> d;
+		for(int r=0; r < n; ++r)
+			d(r,0) = m_ld[r*n+r];
+		return d;
+	};
+
+	//X such that AX = B
+	template<int m>
+	TN_Matrix<datatype,n,m> solve(const TN_Matrix<datatype,n,m> &B) const{
+		TN_Matrix<datatype,n,m> X;
+		substitute(X, [&B](int r, int c){ return B(r,c); });
+		return X;
+	}
+
+	//A^-1, solving against the identity
+	TN_Matrix<datatype,n,n> inverse() const{
+		TN_Matrix<datatype,n,n> X;
+		substitute(X, [](int r, int c){ return datatype((r == c) ? 1 : 0); });
+		return X;
+	};
+};
+
+//X such that AX = B, for symmetric positive-definite A of a floating-point datatype
+template<class datatype, int n, int m>
+TN_Matrix<datatype,n,m> solvecholesky(const TN_Matrix<datatype,n,n> &A, const TN_Matrix<datatype,n,m> &B)
+{
+	return TN_Cholesky<datatype,n>(A).solve(B);
+}
+
+//X such that AX = B, for symmetric non-singular A of a floating-point datatype
+template<class datatype, int n, int m>
+TN_Matrix<datatype,n,m> solveldlt(const TN_Matrix<datatype,n,n> &A, const TN_Matrix<datatype,n,m> &B)
+{
+	return TN_LDLT<datatype,n>(A).solve(B);
+}
+
+//Cofactor expansion
+//******************
+
 //see https://www.geeksforgeeks.org/adjoint-inverse-matrix/
 
 //Function to get cofactor of A[p][q], where "A" is a square matrix of dimensions n*n
@@ -313,96 +837,319 @@ TN_Matrix<datatype,n-1,n-1> cofactor(const TN_Matrix<datatype,n,n> &A, int p, in
 	}
 
 	return temp;
-};
+}
 
 
 
+//through TN_LU for floating-point datatypes, otherwise by cofactor expansion
 template<class datatype, int n>
 datatype determinant(const TN_Matrix<datatype,n,n> &A, int ncol = n)
 {
-	datatype det = 0; // Initialize result
+	if constexpr (n == 1){
+		return A(0,0);
+	}else if constexpr (std::is_floating_point_v<datatype>){
+		return TN_LU<datatype,n>(A).determinant();
+	}else{
+		datatype det = 0; // Initialize result
 
-	//if matrix contains single element
-    /*if (ncol == 1)
-		return A(0,0);*/
+		#ifdef TN_HEAPMATRIX
+			TN_ArenaScope scope; //cofactor temporaries come from the thread's arena
+		#endif
 
-	TN_Matrix<datatype,n-1,n-1> temp; // To store cofactors
-	int sign = 1; // To store sign multiplier
+		TN_Matrix<datatype,n-1,n-1> temp; // To store cofactors
+		int sign = 1; // To store sign multiplier
 
-	// Iterate for each element of first row
-	for(int c = 0; c < ncol; c++) {
-        //Getting Cofactor of A(0,c)
-		temp = cofactor(A, 0, c);
-		det += sign * A(0,c) * determinant(temp, ncol - 1);
+		// Iterate for each element of first row
+		for(int c = 0; c < ncol; c++) {
+			//Getting Cofactor of A(0,c)
+			temp = cofactor(A, 0, c);
+			det += sign * A(0,c) * determinant(temp, ncol - 1);
 
-		//terms are to be added with alternate sign
-		sign = -sign;
+			//terms are to be added with alternate sign
+			sign = -sign;
+		}
+		return det;
 	}
-	return det;
-};
+}
 
 //overload to prevent determinant from recursing once matrix is size 1*1
 template<class datatype>
 datatype determinant(const TN_Matrix<datatype,1,1> &A, int /*ncol*/)
 {
 	return A(0,0);
-};
+}
 
 template<class datatype, int n>
 TN_Matrix<datatype,n,n> adjoint(const TN_Matrix<datatype,n,n> &A)
 {
 	TN_Matrix<datatype,n,n> adj;
 	
-	if (n == 1) {
+	//no cofactors of a 1x1 matrix, whose 0x0 temporaries would not be valid matrices
+	if constexpr (n == 1) {
 		adj(0,0) = 1;
 		return adj;
 	}
+	else {
+		#ifdef TN_HEAPMATRIX
+			TN_ArenaScope scope; //cofactor temporaries come from the thread's arena, adj does not
+		#endif
 
-	//temp is used to store cofactors of A
-    int sign = 1;
-	TN_Matrix<datatype,n-1,n-1> temp;
+		//temp is used to store cofactors of A
+		int sign = 1;
+		TN_Matrix<datatype,n-1,n-1> temp;
 
-	for (int i = 0; i < n; i++) {
-		for (int j = 0; j < n; j++) {
-			// Get cofactor of A[i][j]
-			temp = cofactor(A, i, j);
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < n; j++) {
+				// Get cofactor of A[i][j]
+				temp = cofactor(A, i, j);
 
-			// sign of adj[j][i] positive if sum of row
-			// and column indexes is even.
-			sign = ((i + j) % 2 == 0) ? 1 : -1;
+				// sign of adj[j][i] positive if sum of row
+				// and column indexes is even.
+				sign = ((i + j) % 2 == 0) ? 1 : -1;
 
-			// Interchanging rows and columns to get the
-			// transpose of the cofactor matrix
-			adj(j,i) = (sign) * (determinant(temp, n - 1));
+				// Interchanging rows and columns to get the
+				// transpose of the cofactor matrix
+				adj(j,i) = (sign) * (determinant(temp, n - 1));
+			}
 		}
+		return adj;
 	}
-	return adj;
-};
+}
 
+/*through TN_LU for floating-point datatypes, otherwise by the adjoint. Throws
+std::domain_error if A is singular, as do the closed forms below.*/
 template<class datatype, int n>
 TN_Matrix<datatype,n,n> inverse(const TN_Matrix<datatype,n,n> &A)
 {
 	TN_Matrix<datatype,n,n> inv;
 
-	//Find determinant of A
-	datatype det = determinant(A);
-	if (det == 0) {
-		cout << "Singular matrix, can't find its inverse";
+	if constexpr (std::is_floating_point_v<datatype>){
+		TN_LU<datatype,n> lu(A);
+		lu.checksingular("inverse: singular matrix");
+		return lu.inverse();
+	}else{
+		#ifdef TN_HEAPMATRIX
+			TN_ArenaScope scope; //the adjoint comes from the thread's arena, inv does not
+		#endif
+
+		//Find determinant of A
+		datatype det = determinant(A);
+		if (det == 0)
+			throw std::domain_error("inverse: singular matrix");
+
+		//Find adjoint
+		TN_Matrix<datatype,n,n> adj = adjoint(A);
+
+		//Find Inverse
+		inv = adj/det;
+
 		return inv;
 	}
+}
 
-	//Find adjoint
-	TN_Matrix<datatype,n,n> adj = adjoint(A);
+//Closed forms for 2x2, 3x3 and 4x4
+//*********************************
 
-	//Find Inverse
-	inv = adj/det;
+/*Rotation, strain and transform matrices are mostly 2x2, 3x3 or 4x4, for which determinant(),
+adjoint() and inverse() are overloaded with the unrolled closed forms, which take precedence
+over the general versions above. They have no loops and no branches other than inverse()'s test
+for a singular matrix, and inverse() scales the adjoint by a single reciprocal of the
+determinant as it writes it, so they inline into per-cell loops over arrays of matrices. For
+integers they are exact, as cofactor expansion is.*/
 
-	return inv;
+/*The closed forms are written for any matrix whose cells can be read as A(row,col), so that the
+batched routines of TN_Batched.h can apply them to a SIMD packet of cells of an array at once*/
+template<class matrix>
+inline auto TN_Determinant2(const matrix &A)
+{
+	return A(0,0)*A(1,1) - A(0,1)*A(1,0);
+}
+
+template<class matrix>
+inline auto TN_Determinant3(const matrix &A)
+{
+	return A(0,0)*(A(1,1)*A(2,2) - A(1,2)*A(2,1))
+		 + A(0,1)*(A(1,2)*A(2,0) - A(1,0)*A(2,2))
+		 + A(0,2)*(A(1,0)*A(2,1) - A(1,1)*A(2,0));
+}
+
+template<class datatype>
+inline datatype determinant(const TN_Matrix<datatype,2,2> &A, int /*ncol*/ = 2)
+{
+	return TN_Determinant2(A);
+}
+
+template<class datatype>
+inline datatype determinant(const TN_Matrix<datatype,3,3> &A, int /*ncol*/ = 3)
+{
+	return TN_Determinant3(A);
+}
+
+//2x2 minors of the top two rows, s, and of the bottom two, c, from which both the 4x4
+//determinant and adjoint are built
+template<class datatype>
+struct TN_Minors4{
+	datatype s0, s1, s2, s3, s4, s5;
+	datatype c0, c1, c2, c3, c4, c5;
+
+	template<class matrix>
+	TN_Minors4(const matrix &A) :
+		s0(A(0,0)*A(1,1) - A(1,0)*A(0,1)), s1(A(0,0)*A(1,2) - A(1,0)*A(0,2)),
+		s2(A(0,0)*A(1,3) - A(1,0)*A(0,3)), s3(A(0,1)*A(1,2) - A(1,1)*A(0,2)),
+		s4(A(0,1)*A(1,3) - A(1,1)*A(0,3)), s5(A(0,2)*A(1,3) - A(1,2)*A(0,3)),
+		c0(A(2,0)*A(3,1) - A(3,0)*A(2,1)), c1(A(2,0)*A(3,2) - A(3,0)*A(2,2)),
+		c2(A(2,0)*A(3,3) - A(3,0)*A(2,3)), c3(A(2,1)*A(3,2) - A(3,1)*A(2,2)),
+		c4(A(2,1)*A(3,3) - A(3,1)*A(2,3)), c5(A(2,2)*A(3,3) - A(3,2)*A(2,3))
+	{}
+
+	inline datatype determinant() const{
+		return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+	};
 };
 
+template<class datatype>
+inline datatype determinant(const TN_Matrix<datatype,4,4> &A, int /*ncol*/ = 4)
+{
+	return TN_Minors4<datatype>(A).determinant();
+}
+
+/*The adjoints, cell by cell as f(cell), so that inverse() can scale each cell as it is written
+rather than in a second pass over the matrix*/
+template<class matrix, class adjmatrix, class func>
+inline void TN_Adjoint2(const matrix &A, adjmatrix &adj, func f)
+{
+	adj(0,0) = f(A(1,1));  adj(0,1) = f(-A(0,1));
+	adj(1,0) = f(-A(1,0)); adj(1,1) = f(A(0,0));
+}
+
+template<class matrix, class adjmatrix, class func>
+inline void TN_Adjoint3(const matrix &A, adjmatrix &adj, func f)
+{
+	adj(0,0) = f(A(1,1)*A(2,2) - A(1,2)*A(2,1));
+	adj(0,1) = f(A(0,2)*A(2,1) - A(0,1)*A(2,2));
+	adj(0,2) = f(A(0,1)*A(1,2) - A(0,2)*A(1,1));
+	adj(1,0) = f(A(1,2)*A(2,0) - A(1,0)*A(2,2));
+	adj(1,1) = f(A(0,0)*A(2,2) - A(0,2)*A(2,0));
+	adj(1,2) = f(A(0,2)*A(1,0) - A(0,0)*A(1,2));
+	adj(2,0) = f(A(1,0)*A(2,1) - A(1,1)*A(2,0));
+	adj(2,1) = f(A(0,1)*A(2,0) - A(0,0)*A(2,1));
+	adj(2,2) = f(A(0,0)*A(1,1) - A(0,1)*A(1,0));
+}
+
+template<class matrix, class minors, class adjmatrix, class func>
+inline void TN_Adjoint4(const matrix &A, const minors &m, adjmatrix &adj, func f)
+{
+	adj(0,0) = f( A(1,1)*m.c5 - A(1,2)*m.c4 + A(1,3)*m.c3);
+	adj(0,1) = f(-A(0,1)*m.c5 + A(0,2)*m.c4 - A(0,3)*m.c3);
+	adj(0,2) = f( A(3,1)*m.s5 - A(3,2)*m.s4 + A(3,3)*m.s3);
+	adj(0,3) = f(-A(2,1)*m.s5 + A(2,2)*m.s4 - A(2,3)*m.s3);
+	adj(1,0) = f(-A(1,0)*m.c5 + A(1,2)*m.c2 - A(1,3)*m.c1);
+	adj(1,1) = f( A(0,0)*m.c5 - A(0,2)*m.c2 + A(0,3)*m.c1);
+	adj(1,2) = f(-A(3,0)*m.s5 + A(3,2)*m.s2 - A(3,3)*m.s1);
+	adj(1,3) = f( A(2,0)*m.s5 - A(2,2)*m.s2 + A(2,3)*m.s1);
+	adj(2,0) = f( A(1,0)*m.c4 - A(1,1)*m.c2 + A(1,3)*m.c0);
+	adj(2,1) = f(-A(0,0)*m.c4 + A(0,1)*m.c2 - A(0,3)*m.c0);
+	adj(2,2) = f( A(3,0)*m.s4 - A(3,1)*m.s2 + A(3,3)*m.s0);
+	adj(2,3) = f(-A(2,0)*m.s4 + A(2,1)*m.s2 - A(2,3)*m.s0);
+	adj(3,0) = f(-A(1,0)*m.c3 + A(1,1)*m.c1 - A(1,2)*m.c0);
+	adj(3,1) = f( A(0,0)*m.c3 - A(0,1)*m.c1 + A(0,2)*m.c0);
+	adj(3,2) = f(-A(3,0)*m.s3 + A(3,1)*m.s1 - A(3,2)*m.s0);
+	adj(3,3) = f( A(2,0)*m.s3 - A(2,1)*m.s1 + A(2,2)*m.s0);
+}
+
+template<class datatype>
+inline TN_Matrix<datatype,2,2> adjoint(const TN_Matrix<datatype,2,2> &A)
+{
+	TN_Matrix<datatype,2,2> adj;
+	TN_Adjoint2(A, adj, [](datatype x){ return x; });
+	return adj;
+}
+
+template<class datatype>
+inline TN_Matrix<datatype,3,3> adjoint(const TN_Matrix<datatype,3,3> &A)
+{
+	TN_Matrix<datatype,3,3> adj;
+	TN_Adjoint3(A, adj, [](datatype x){ return x; });
+	return adj;
+}
+
+template<class datatype>
+inline TN_Matrix<datatype,4,4> adjoint(const TN_Matrix<datatype,4,4> &A)
+{
+	TN_Matrix<datatype,4,4> adj;
+	TN_Adjoint4(A, TN_Minors4<datatype>(A), adj, [](datatype x){ return x; });
+	return adj;
+}
+
+/*inv = adjoint/det, written by adjoint(inv, f) with each cell times one reciprocal of the
+determinant for floating-point datatypes, or divided by it as before for integers. Returns
+false, with inv 0, if det is 0.*/
+template<class datatype, int n, class adjointfunc>
+inline bool TN_ClosedInverse(datatype det, TN_Matrix<datatype,n,n> &inv, adjointfunc adjoint)
+{
+	if (det == 0) {
+		inv = datatype(0);
+		return false;
+	}else if constexpr (std::is_floating_point_v<datatype>){
+		datatype rdet = datatype(1)/det;
+		adjoint(inv, [rdet](datatype x){ return x*rdet; });
+	}else{
+		adjoint(inv, [det](datatype x){ return x/det; });
+	}
+	return true;
+}
+
+//inv = A^-1 by the closed forms, false with inv 0 if A is singular
+template<class datatype>
+inline bool TN_ClosedInverse(const TN_Matrix<datatype,2,2> &A, TN_Matrix<datatype,2,2> &inv)
+{
+	return TN_ClosedInverse(determinant(A), inv, [&](TN_Matrix<datatype,2,2> &out, auto f){
+		TN_Adjoint2(A, out, f);
+	});
+}
+
+template<class datatype>
+inline bool TN_ClosedInverse(const TN_Matrix<datatype,3,3> &A, TN_Matrix<datatype,3,3> &inv)
+{
+	return TN_ClosedInverse(determinant(A), inv, [&](TN_Matrix<datatype,3,3> &out, auto f){
+		TN_Adjoint3(A, out, f);
+	});
+}
 
+template<class datatype>
+inline bool TN_ClosedInverse(const TN_Matrix<datatype,4,4> &A, TN_Matrix<datatype,4,4> &inv)
+{
+	TN_Minors4<datatype> m(A);
+	return TN_ClosedInverse(m.determinant(), inv, [&](TN_Matrix<datatype,4,4> &out, auto f){
+		TN_Adjoint4(A, m, out, f);
+	});
+}
 
+template<class datatype>
+inline TN_Matrix<datatype,2,2> inverse(const TN_Matrix<datatype,2,2> &A)
+{
+	TN_Matrix<datatype,2,2> inv;
+	if(!TN_ClosedInverse(A, inv))
+		throw std::domain_error("inverse: singular matrix");
+	return inv;
+}
 
+template<class datatype>
+inline TN_Matrix<datatype,3,3> inverse(const TN_Matrix<datatype,3,3> &A)
+{
+	TN_Matrix<datatype,3,3> inv;
+	if(!TN_ClosedInverse(A, inv))
+		throw std::domain_error("inverse: singular matrix");
+	return inv;
+}
 
+template<class datatype>
+inline TN_Matrix<datatype,4,4> inverse(const TN_Matrix<datatype,4,4> &A)
+{
+	TN_Matrix<datatype,4,4> inv;
+	if(!TN_ClosedInverse(A, inv))
+		throw std::domain_error("inverse: singular matrix");
+	return inv;
+}
 
 #endif //TN_Matrix
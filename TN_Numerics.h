@@ -10,8 +10,16 @@ Copyright Ben McLean 2023
 
 //TN_Arrays and Matrices
 #include "TN_ExprTemp.h"
+#include "TN_Arena.h"
+#include "TN_Allocator.h"
+#include "TN_Simd.h"
+#include "TN_Plan.h"
 #include "TN_Matrix.h"
+#include "TN_ArrayView.h"
 #include "TN_Array.h"
+#include "TN_ArraySoA.h"
+#include "TN_MappedArray.h"
+#include "TN_TiledArray.h"
 #include "TN_StructAddOp.h"
 #include "TN_OperatorAdd.h"
 #include "TN_StructSubOp.h"
@@ -19,4 +27,11 @@ Copyright Ben McLean 2023
 #include "TN_StructMulOp.h"
 #include "TN_OperatorMul.h"
 #include "TN_StructDivOp.h"
-#include "TN_OperatorDiv.h"
\ No newline at end of file
+#include "TN_OperatorDiv.h"
+#include "TN_StructUnaryOp.h"
+#include "TN_OperatorUnary.h"
+#include "TN_Reduce.h"
+#include "TN_StructCompareOp.h"
+#include "TN_OperatorCompare.h"
+#include "TN_Tie.h"
+#include "TN_Batched.h"
\ No newline at end of file
@@ -0,0 +1,122 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+#ifndef TN_OPERATORCOMPARE
+#define TN_OPERATORCOMPARE
+
+#include <type_traits>
+
+/*
+TN_Compare<Op>(A, B) builds the mask comparing A and B, of which one at least is an array,
+view, tiled array, array of matrices or expression of them, and the other the same or a
+scalar, of the pattern:
+template<templated params>
+static inline auto
+TN_Compare(const LHS &A, const RHS &B){
+	return BinExpr<LHS, _OPNAME, RHS, NROWS, NCOLS, RTNTYPE> (A,B);
+}
+and A < B, A <= B, A > B and A >= B are defined for every pair it is. == and != are left to
+their existing meanings, e.g. whether two whole arrays are equal.
+*/
+
+//operands of a cell-by-cell operation with cells of datatype: scalars, or anything of datatype
+template <class T, class datatype, class = void>
+struct TN_IsCellOperand : std::is_arithmetic<T> {};
+
+template <class T, class datatype>
+struct TN_IsCellOperand<T, datatype, std::void_t<typename TN_ScalarType<T>::type> > :
+	std::is_same<typename TN_ScalarType<T>::type, datatype> {};
+
+//array op array
+template <class Op, class L, class R,
+		  std::enable_if_t<TN_HasExtent<L>::value && TN_HasExtent<R>::value &&
+						   std::is_same_v<typename TN_ScalarType<L>::type, typename TN_ScalarType<R>::type>, int> = 0>
+static inline auto
+TN_Compare(const L &A, const R &B)
+{
+	return TN_CellwiseNode<Op, TN_CellShape<L, R>::nrows, TN_CellShape<L, R>::ncols>(A, B);
+}
+
+//array op datatype
+template <class Op, class L, std::enable_if_t<TN_HasExtent<L>::value, int> = 0>
+static inline auto
+TN_Compare(const L &A, const typename TN_ScalarType<L>::type &B)
+{
+	return TN_CellwiseNode<Op, TN_CellShape<L>::nrows, TN_CellShape<L>::ncols>(A, B);
+}
+
+//datatype op array
+template <class Op, class R, std::enable_if_t<TN_HasExtent<R>::value, int> = 0>
+static inline auto
+TN_Compare(const typename TN_ScalarType<R>::type &A, const R &B)
+{
+	return TN_CellwiseNode<Op, TN_CellShape<R>::nrows, TN_CellShape<R>::ncols>(A, B);
+}
+
+//Operators
+//*********
+
+template <class L, class R>
+static inline auto
+operator<(const L &A, const R &B) -> decltype(TN_Compare<LtOp>(A, B))
+{
+	return TN_Compare<LtOp>(A, B);
+}
+
+template <class L, class R>
+static inline auto
+operator<=(const L &A, const R &B) -> decltype(TN_Compare<LeOp>(A, B))
+{
+	return TN_Compare<LeOp>(A, B);
+}
+
+template <class L, class R>
+static inline auto
+operator>(const L &A, const R &B) -> decltype(TN_Compare<GtOp>(A, B))
+{
+	return TN_Compare<GtOp>(A, B);
+}
+
+template <class L, class R>
+static inline auto
+operator>=(const L &A, const R &B) -> decltype(TN_Compare<GeOp>(A, B))
+{
+	return TN_Compare<GeOp>(A, B);
+}
+
+//Where
+//*****
+
+//scalars as operands of datatype
+template <class datatype, class T>
+inline decltype(auto) TN_AsOperand(const T &operand)
+{
+	if constexpr (std::is_arithmetic_v<T>)
+		return datatype(operand);
+	else
+		return (operand);
+}
+
+/*a where mask is not 0, otherwise b, cell by cell, or for masks of matrices component by
+component. mask is an array, view, tiled array, array of matrices or expression of them, e.g.
+a comparison, and a and b may each be the same, or a scalar, or for arrays of matrices a matrix,
+all of the mask's datatype. Like every other operation it is evaluated in the assignment's
+single pass, without a boolean array, and for arrays of doubles or floats in packets.*/
+template <class M, class A, class B,
+		  std::enable_if_t<TN_HasExtent<M>::value &&
+						   TN_IsCellOperand<A, typename TN_ScalarType<M>::type>::value &&
+						   TN_IsCellOperand<B, typename TN_ScalarType<M>::type>::value, int> = 0>
+static inline auto
+where(const M &mask, const A &a, const B &b)
+{
+	typedef typename TN_ScalarType<M>::type datatype;
+	typedef TN_CellShape<M, A, B> shape;
+	return TN_CellwiseNode<ElseOp, shape::nrows, shape::ncols>(
+		TN_CellwiseNode<SelectOp, shape::nrows, shape::ncols>(mask, TN_AsOperand<datatype>(a)),
+		TN_AsOperand<datatype>(b));
+}
+
+#endif //TN_OPERATORCOMPARE
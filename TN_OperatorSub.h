@@ -344,6 +344,128 @@ operator -(	const ArrBinExpr<lhs1,op1,rhs1,datatype> &A,
 }
 
 
+// LHS or RHS TN_ArrayView
+//************************
+
+// datatype op view
+template <class datatype>
+static inline auto
+operator-(const datatype &A, const TN_ArrayView<datatype> &B)
+{
+	return ArrBinExpr<datatype, SubOp, TN_ArrayView<datatype>, datatype>(A, B);
+}
+
+// view op datatype
+template <class datatype>
+static inline auto
+operator-(const TN_ArrayView<datatype> &A, const datatype &B)
+{
+	return ArrBinExpr<TN_ArrayView<datatype>, SubOp, datatype, datatype>(A, B);
+}
+
+// view op view
+template <class datatype>
+static inline auto
+operator-(const TN_ArrayView<datatype> &A, const TN_ArrayView<datatype> &B)
+{
+	return ArrBinExpr<TN_ArrayView<datatype>, SubOp, TN_ArrayView<datatype>, datatype>(A, B);
+}
+
+// view op array
+template <class datatype>
+static inline auto
+operator-(const TN_ArrayView<datatype> &A, const TN_Array<datatype> &B)
+{
+	return ArrBinExpr<TN_ArrayView<datatype>, SubOp, TN_Array<datatype>, datatype>(A, B);
+}
+
+// array op view
+template <class datatype>
+static inline auto
+operator-(const TN_Array<datatype> &A, const TN_ArrayView<datatype> &B)
+{
+	return ArrBinExpr<TN_Array<datatype>, SubOp, TN_ArrayView<datatype>, datatype>(A, B);
+}
+
+// view op ArrBinExpr
+template <class lhs, class op, class rhs, class datatype>
+static inline auto
+operator-(const TN_ArrayView<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B)
+{
+	return ArrBinExpr<TN_ArrayView<datatype>, SubOp, ArrBinExpr<lhs, op, rhs, datatype>, datatype>(A, B);
+}
+
+// ArrBinExpr op view
+template <class lhs, class op, class rhs, class datatype>
+static inline auto
+operator-(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_ArrayView<datatype> &B)
+{
+	return ArrBinExpr<ArrBinExpr<lhs, op, rhs, datatype>, SubOp, TN_ArrayView<datatype>, datatype>(A, B);
+}
+
+// views with arrays of matrices not defined
+
+// LHS or RHS TN_TiledArray
+//*************************
+
+// datatype op tiled
+template <class datatype>
+static inline auto
+operator-(const datatype &A, const TN_TiledArray<datatype> &B)
+{
+	return ArrBinExpr<datatype, SubOp, TN_TiledArray<datatype>, datatype>(A, B);
+}
+
+// tiled op datatype
+template <class datatype>
+static inline auto
+operator-(const TN_TiledArray<datatype> &A, const datatype &B)
+{
+	return ArrBinExpr<TN_TiledArray<datatype>, SubOp, datatype, datatype>(A, B);
+}
+
+// tiled op tiled
+template <class datatype>
+static inline auto
+operator-(const TN_TiledArray<datatype> &A, const TN_TiledArray<datatype> &B)
+{
+	return ArrBinExpr<TN_TiledArray<datatype>, SubOp, TN_TiledArray<datatype>, datatype>(A, B);
+}
+
+// tiled op array
+template <class datatype>
+static inline auto
+operator-(const TN_TiledArray<datatype> &A, const TN_Array<datatype> &B)
+{
+	return ArrBinExpr<TN_TiledArray<datatype>, SubOp, TN_Array<datatype>, datatype>(A, B);
+}
+
+// array op tiled
+template <class datatype>
+static inline auto
+operator-(const TN_Array<datatype> &A, const TN_TiledArray<datatype> &B)
+{
+	return ArrBinExpr<TN_Array<datatype>, SubOp, TN_TiledArray<datatype>, datatype>(A, B);
+}
+
+// tiled op ArrBinExpr
+template <class lhs, class op, class rhs, class datatype>
+static inline auto
+operator-(const TN_TiledArray<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B)
+{
+	return ArrBinExpr<TN_TiledArray<datatype>, SubOp, ArrBinExpr<lhs, op, rhs, datatype>, datatype>(A, B);
+}
+
+// ArrBinExpr op tiled
+template <class lhs, class op, class rhs, class datatype>
+static inline auto
+operator-(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_TiledArray<datatype> &B)
+{
+	return ArrBinExpr<ArrBinExpr<lhs, op, rhs, datatype>, SubOp, TN_TiledArray<datatype>, datatype>(A, B);
+}
+
+// tiled arrays with views or arrays of matrices not defined
+
 // LHS array<matrix>
 //*****************
 
@@ -0,0 +1,205 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+#ifndef TN_OPERATORUNARY
+#define TN_OPERATORUNARY
+
+#include <type_traits>
+
+/*
+TN_Unary<Op>(A, p) builds the node applying Op to every cell of A, with parameter p, and is
+of the pattern:
+template<templated params>
+static inline auto
+TN_Unary(const LHS &A, const datatype &B){
+	return BinExpr<LHS, _OPNAME, datatype, NROWS, NCOLS, RTNTYPE> (A,B);
+}
+The functions, -A, abs(A), sqrt(A), exp(A), log(A), pow(A,p), min(A,s) and max(A,s), are
+defined for every operand TN_Unary is, and leave scalars to <cmath>.
+*/
+
+// matrix
+template <class Op, class datatype, int nrows, int ncols>
+static inline auto
+TN_Unary(const TN_Matrix<datatype, nrows, ncols> &A, const datatype &B)
+{
+	return MatBinExpr<TN_Matrix<datatype, nrows, ncols>, Op, datatype, nrows, ncols, datatype>(A, B);
+}
+
+// MatBinExpr
+template <class Op, class lhs, class op, class rhs, int nrows, int ncols, class datatype>
+static inline auto
+TN_Unary(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const datatype &B)
+{
+	return MatBinExpr<MatBinExpr<lhs, op, rhs, nrows, ncols, datatype>, Op, datatype, nrows, ncols, datatype>(A, B);
+}
+
+// array, or an array derived from one, e.g. TN_MappedArray
+template <class Op, class datatype, class allocator>
+static inline auto
+TN_Unary(const TN_Array<datatype, allocator> &A, const datatype &B)
+{
+	return ArrBinExpr<TN_Array<datatype, allocator>, Op, datatype, datatype>(A, B);
+}
+
+// ArrBinExpr
+template <class Op, class lhs, class op, class rhs, class datatype>
+static inline auto
+TN_Unary(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B)
+{
+	return ArrBinExpr<ArrBinExpr<lhs, op, rhs, datatype>, Op, datatype, datatype>(A, B);
+}
+
+// view
+template <class Op, class datatype, class allocator>
+static inline auto
+TN_Unary(const TN_ArrayView<datatype, allocator> &A, const datatype &B)
+{
+	return ArrBinExpr<TN_ArrayView<datatype, allocator>, Op, datatype, datatype>(A, B);
+}
+
+// tiled
+template <class Op, class datatype>
+static inline auto
+TN_Unary(const TN_TiledArray<datatype> &A, const datatype &B)
+{
+	return ArrBinExpr<TN_TiledArray<datatype>, Op, datatype, datatype>(A, B);
+}
+
+// arrmat
+template <class Op, class datatype, int nrows, int ncols, class allocator>
+static inline auto
+TN_Unary(const TN_Array<TN_Matrix<datatype, nrows, ncols>, allocator> &A, const datatype &B)
+{
+	return ArrMatBinExpr<	TN_Array<TN_Matrix<datatype, nrows, ncols>, allocator>,
+							Op,
+							datatype,
+							nrows, ncols,
+							MatBinExpr<TN_Matrix<datatype, nrows, ncols>, Op, datatype, nrows, ncols, datatype> >(A, B);
+}
+
+// ArrMatBinExpr
+template <class Op, class lhs, class op, class rhs, int nrows, int ncols, class rtn, class datatype>
+static inline auto
+TN_Unary(const ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtn> &A, const datatype &B)
+{
+	return ArrMatBinExpr<	ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtn>,
+							Op,
+							datatype,
+							nrows, ncols,
+							MatBinExpr<TN_Matrix<datatype, nrows, ncols>, Op, datatype, nrows, ncols, datatype> >(A, B);
+}
+
+//TN_ScalarType<T>::type is the datatype of the cells, or matrix cells, of T, and is only
+//defined for the operands above, so that the functions below leave everything else alone
+template <class T, class = void>
+struct TN_ScalarType {};
+
+template <class datatype, int nrows, int ncols>
+struct TN_ScalarType<TN_Matrix<datatype, nrows, ncols> > { typedef datatype type; };
+
+template <class lhs, class op, class rhs, int nrows, int ncols, class datatype>
+struct TN_ScalarType<MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> > { typedef datatype type; };
+
+template <class datatype, class allocator>
+struct TN_ScalarType<TN_Array<datatype, allocator> > { typedef datatype type; };
+
+template <class lhs, class op, class rhs, class datatype>
+struct TN_ScalarType<ArrBinExpr<lhs, op, rhs, datatype> > { typedef datatype type; };
+
+template <class datatype, class allocator>
+struct TN_ScalarType<TN_ArrayView<datatype, allocator> > { typedef datatype type; };
+
+template <class datatype>
+struct TN_ScalarType<TN_TiledArray<datatype> > { typedef datatype type; };
+
+template <class datatype, int nrows, int ncols, class allocator>
+struct TN_ScalarType<TN_Array<TN_Matrix<datatype, nrows, ncols>, allocator> > { typedef datatype type; };
+
+//arrays derived from TN_Array, e.g. TN_MappedArray, as the arrays they are
+template <class T>
+struct TN_ScalarType<T, std::enable_if_t<TN_IsDerivedArray<T>::value> > : TN_ScalarType<TN_ArrayOperand<T> > {};
+
+template <class lhs, class op, class rhs, int nrows, int ncols, class rtn>
+struct TN_ScalarType<ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtn> > : TN_ScalarType<rtn> {};
+
+//Functions
+//*********
+
+// -A
+template <class T>
+static inline auto
+operator-(const T &A) -> decltype(TN_Unary<NegOp>(A, typename TN_ScalarType<T>::type()))
+{
+	return TN_Unary<NegOp>(A, typename TN_ScalarType<T>::type());
+}
+
+template <class T>
+static inline auto
+abs(const T &A) -> decltype(TN_Unary<AbsOp>(A, typename TN_ScalarType<T>::type()))
+{
+	return TN_Unary<AbsOp>(A, typename TN_ScalarType<T>::type());
+}
+
+template <class T>
+static inline auto
+sqrt(const T &A) -> decltype(TN_Unary<SqrtOp>(A, typename TN_ScalarType<T>::type()))
+{
+	return TN_Unary<SqrtOp>(A, typename TN_ScalarType<T>::type());
+}
+
+template <class T>
+static inline auto
+exp(const T &A) -> decltype(TN_Unary<ExpOp>(A, typename TN_ScalarType<T>::type()))
+{
+	return TN_Unary<ExpOp>(A, typename TN_ScalarType<T>::type());
+}
+
+template <class T>
+static inline auto
+log(const T &A) -> decltype(TN_Unary<LogOp>(A, typename TN_ScalarType<T>::type()))
+{
+	return TN_Unary<LogOp>(A, typename TN_ScalarType<T>::type());
+}
+
+// A to the power p, cell by cell
+template <class T>
+static inline auto
+pow(const T &A, const typename TN_ScalarType<T>::type &p) -> decltype(TN_Unary<PowOp>(A, p))
+{
+	return TN_Unary<PowOp>(A, p);
+}
+
+// min and max of each cell with a scalar
+template <class T>
+static inline auto
+min(const T &A, const typename TN_ScalarType<T>::type &s) -> decltype(TN_Unary<MinOp>(A, s))
+{
+	return TN_Unary<MinOp>(A, s);
+}
+
+template <class T>
+static inline auto
+min(const typename TN_ScalarType<T>::type &s, const T &A) -> decltype(TN_Unary<MinOp>(A, s))
+{
+	return TN_Unary<MinOp>(A, s);
+}
+
+template <class T>
+static inline auto
+max(const T &A, const typename TN_ScalarType<T>::type &s) -> decltype(TN_Unary<MaxOp>(A, s))
+{
+	return TN_Unary<MaxOp>(A, s);
+}
+
+template <class T>
+static inline auto
+max(const typename TN_ScalarType<T>::type &s, const T &A) -> decltype(TN_Unary<MaxOp>(A, s))
+{
+	return TN_Unary<MaxOp>(A, s);
+}
+
+#endif //TN_OPERATORUNARY
@@ -0,0 +1,115 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//*************
+//class TN_Plan
+//*************
+//materialisation of the nested matrix products in an expression that would otherwise be
+//recomputed for every cell that reads them, within a memory budget.
+
+#ifndef TN_PLAN
+#define TN_PLAN
+
+#include <cstddef>
+#include <type_traits>
+
+/*Bytes of scratch matrices that evaluating one matrix expression may use, i.e. one cell of an
+array of matrices, so one set per thread. #define TN_SCRATCHBYTES 0 to evaluate every
+expression straight through, as written.*/
+#ifndef TN_SCRATCHBYTES
+	#define TN_SCRATCHBYTES 65536
+#endif
+
+/*A product reads each cell of its left operand once per column of the result, and each cell
+of its right operand once per row, so in A = B * (C * D) every cell of C * D, itself a sum
+over a row of C and a column of D, is computed once per row of B. Every product in an
+expression that is evaluated more than once per cell is materialised into a scratch matrix
+first when recomputing it would cost more than writing it once and reading it back, e.g.
+temp = C * D; A = B * temp. The decisions are made at compile time from the dimensions:
+	factor - times each cell of the subexpression is evaluated, the product of the rows or
+			columns of the products above it, up to the nearest one materialised
+	cost - operations per cell of the subexpression, evaluated straight through
+The products are taken outermost first, while they fit in the remaining budget; once one is
+materialised the products inside it are only recomputed for its own cells.*/
+
+//columns of a matrix operand, which is the inner dimension of a product it is the left of
+template<class T>
+struct TN_MatrixCols : std::integral_constant<int, 1> {};
+
+template<class datatype, int nrows, int ncols>
+struct TN_MatrixCols<TN_Matrix<datatype, nrows, ncols> > : std::integral_constant<int, ncols> {};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class RtnType>
+struct TN_MatrixCols<MatBinExpr<LHS, Op, RHS, nrows, ncols, RtnType> > : std::integral_constant<int, ncols> {};
+
+//terminals and scalars are read in place
+template<class expr, size_t factor, size_t budget>
+struct TN_Plan{
+
+	static constexpr size_t cost = 0;
+	static constexpr size_t bytes = 0;
+	static constexpr bool changes = false;
+
+	template<class func>
+	static inline void apply(const expr &expression, func &&f){
+		f(expression);
+	}
+};
+
+template<class LHS, class Op, class RHS, int nrows, int ncols, class datatype, size_t factor, size_t budget>
+struct TN_Plan<MatBinExpr<LHS, Op, RHS, nrows, ncols, datatype>, factor, budget>{
+
+	static constexpr bool product = TN_IsProduct<LHS, Op, RHS>::value;
+	static constexpr size_t inner = TN_MatrixCols<LHS>::value;
+
+	static constexpr size_t cost = product ?
+		inner*(2 + TN_Plan<LHS, 1, 0>::cost + TN_Plan<RHS, 1, 0>::cost) :
+		1 + TN_Plan<LHS, 1, 0>::cost + TN_Plan<RHS, 1, 0>::cost;
+
+	//materialised, a product costs one write and factor reads per cell, rather than factor*cost
+	static constexpr size_t ownbytes = size_t(nrows)*ncols*sizeof(datatype);
+	static constexpr bool materialise = product && factor > 1 &&
+		(factor - 1)*cost > factor + 1 && ownbytes <= budget;
+
+	static constexpr size_t base = materialise ? 1 : factor;
+	static constexpr size_t avail = materialise ? budget - ownbytes : budget;
+
+	typedef TN_Plan<LHS, product ? base*ncols : base, avail> left;
+	typedef TN_Plan<RHS, product ? base*nrows : base, avail - left::bytes> right;
+
+	static constexpr size_t bytes = (materialise ? ownbytes : 0) + left::bytes + right::bytes;
+	static constexpr bool changes = materialise || left::changes || right::changes;
+
+	/*calls f with the planned expression, in which materialised products are scratch
+	matrices, computed beforehand on this thread's stack, or with TN_HEAPMATRIX in its arena
+	if a TN_ArenaScope is open*/
+	template<class func>
+	static inline void apply(const MatBinExpr<LHS, Op, RHS, nrows, ncols, datatype> &expression, func &&f){
+		if constexpr (!changes){
+			f(expression);
+		}else{
+			left::apply(expression.left(), [&](const auto &l){
+				right::apply(expression.right(), [&](const auto &r){
+					MatBinExpr<std::decay_t<decltype(l)>, Op, std::decay_t<decltype(r)>, nrows, ncols, datatype> planned(l, r);
+					if constexpr (materialise){
+						TN_Matrix<datatype, nrows, ncols> scratch;
+						for(int i=0; i < nrows*ncols; ++i)
+							scratch[i] = planned.calc(i);
+						f(scratch);
+					}else{
+						f(planned);
+					}
+				});
+			});
+		}
+	}
+};
+
+//whether assigning expr materialises any of its products
+template<class expr>
+struct TN_IsPlanned : std::bool_constant<TN_Plan<expr, 1, TN_SCRATCHBYTES>::changes> {};
+
+#endif //TN_PLAN
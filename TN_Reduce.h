@@ -0,0 +1,351 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//**************
+//Reductions
+//**************
+//sum, mean, dot, norm, min, max, argmin and argmax of arrays, views, tiled arrays, arrays of
+//matrices and expressions of them, evaluated in a single parallel pass without temporaries.
+
+#ifndef TN_REDUCE
+#define TN_REDUCE
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+/*Reductions walk the cells of an expression in rows, in parallel over rows with
+TN_PARALLELARRAY, and within each row in vector registers where the cells are scalars.
+Each thread accumulates its own partial result, and the partials are combined as the threads
+finish, so sums may differ in their last bits from one run, or thread count, to the next.
+#define TN_DETERMINISTIC to accumulate fixed blocks of about TN_REDUCEBLOCK cells each instead,
+and combine them in order, so that results depend only on the array sizes. min, max, argmin
+and argmax are exact either way; ties go to the cell with the lowest index.*/
+#ifndef TN_REDUCEBLOCK
+	#define TN_REDUCEBLOCK 4096
+#endif
+
+//the value a cell of T is accumulated into: its datatype, or for arrays of matrices its matrix
+template<class T, class = void>
+struct TN_CellType{
+	typedef std::decay_t<decltype(std::declval<const T &>().calc(TN_Index(0)))> type;
+};
+
+template<class T>
+struct TN_CellType<T, std::enable_if_t<TN_IsDerivedArray<T>::value> > : TN_CellType<TN_ArrayOperand<T> > {};
+
+template<class datatype, int nrows, int ncols, class allocator>
+struct TN_CellType<TN_Array<TN_Matrix<datatype, nrows, ncols>, allocator> >{
+	typedef TN_Matrix<datatype, nrows, ncols> type;
+};
+
+template<class lhs, class op, class rhs, int nrows, int ncols, class rtn>
+struct TN_CellType<ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtn> >{
+	typedef TN_Matrix<typename TN_ScalarType<rtn>::type, nrows, ncols> type;
+};
+
+/*The cells reductions walk: the rows of an (nx,ny,nz) array, which skip any padding, or for
+unpadded arrays rows of TN_REDUCEBLOCK consecutive cells, so that short rows still make long
+SIMD loops.*/
+struct TN_Extent{
+	TN_Index m_nx, m_ny, m_nz, m_nzpad;
+
+	inline TN_Index get_ncells() const {
+		return m_nx*m_ny*m_nz;
+	};
+
+	inline TN_Index get_rowlength() const {
+		return (m_nzpad == m_nz) ? TN_Index(TN_REDUCEBLOCK) : m_nz;
+	};
+
+	inline TN_Index get_nrows() const {
+		return (m_nzpad == m_nz) ? (get_ncells() + TN_REDUCEBLOCK - 1)/TN_REDUCEBLOCK : m_nx*m_ny;
+	};
+
+	inline TN_Index begin(TN_Index row) const {
+		return (m_nzpad == m_nz) ? row*TN_REDUCEBLOCK : row*m_nzpad;
+	};
+
+	inline TN_Index end(TN_Index row) const {
+		return (m_nzpad == m_nz) ? std::min(get_ncells(), (row + 1)*TN_REDUCEBLOCK) : row*m_nzpad + m_nz;
+	};
+};
+
+template<class T>
+inline TN_Extent TN_GetExtent(const T &operand){
+	if constexpr (TN_IsExprNode<T>::value){
+		if constexpr (TN_HasExtent<std::decay_t<decltype(operand.left())> >::value)
+			return TN_GetExtent(operand.left());
+		else
+			return TN_GetExtent(operand.right());
+	}else{
+		return TN_Extent{operand.get_nx(), operand.get_ny(), operand.get_nz(), operand.get_nzpad()};
+	}
+}
+
+//Reduction kernel
+//****************
+
+/*reduces the rows of extent into a T, starting from identity: reducerow(partial, begin, end)
+accumulates cells [begin,end) into a partial result, and join(result, partial) combines two*/
+template<class T, class rowfunc, class joinfunc>
+inline T TN_ReduceRows(const TN_Extent &extent, const T &identity, rowfunc reducerow, joinfunc join){
+	TN_Index nrows = extent.get_nrows();
+	T result = identity;
+	#ifdef TN_DETERMINISTIC
+		TN_Index blockrows = std::max(TN_Index(1), TN_Index(TN_REDUCEBLOCK)/extent.get_rowlength());
+		TN_Index nblocks = (nrows + blockrows - 1)/blockrows;
+		std::vector<T> partials(nblocks, identity);
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index block=0; block < nblocks; ++block){
+			for(TN_Index row=block*blockrows; row < std::min(nrows, (block + 1)*blockrows); ++row){
+				reducerow(partials[block], extent.begin(row), extent.end(row));
+			}
+		}
+		for(TN_Index block=0; block < nblocks; ++block){
+			join(result, partials[block]);
+		}
+	#else
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel
+		#endif
+		{
+			T partial = identity;
+			#ifdef TN_PARALLELARRAY
+				#pragma omp for schedule(static) nowait
+			#endif
+			for(TN_Index row=0; row < nrows; ++row){
+				reducerow(partial, extent.begin(row), extent.end(row));
+			}
+			#ifdef TN_PARALLELARRAY
+				#pragma omp critical
+			#endif
+			join(result, partial);
+		}
+	#endif
+	return result;
+}
+
+/*reduces the cells of expression, and of the other operands read with it, as TN_ReduceRows
+does. Expressions that read out-of-core arrays are reduced one x plane at a time, first reading
+one cell of the plane of each operand serially so that the tiles it needs are loaded before
+the threads read them, as in array assignment; the planes are joined in order.*/
+template<class T, class expr, class rowfunc, class joinfunc, class... others>
+inline T TN_ReduceCells(const expr &expression, const T &identity, rowfunc reducerow, joinfunc join, const others &... operands){
+	TN_Extent extent = TN_GetExtent(expression);
+	if constexpr (TN_IsOutOfCore<expr>::value || (TN_IsOutOfCore<others>::value || ...)){
+		TN_Extent plane{1, extent.m_ny, extent.m_nz, extent.m_nzpad};
+		TN_Index nynz = extent.m_ny*extent.m_nzpad;
+		T result = identity;
+		for(TN_Index x=0; x < extent.m_nx; ++x){
+			TN_Index first = x*nynz;
+			(void)expression.calc(first);
+			((void)operands.calc(first), ...);
+			join(result, TN_ReduceRows(plane, identity,
+				[&](T &partial, TN_Index begin, TN_Index end){ reducerow(partial, first + begin, first + end); },
+				join));
+		}
+		return result;
+	}else{
+		return TN_ReduceRows(extent, identity, reducerow, join);
+	}
+}
+
+//zero of a datatype or matrix
+template<class T>
+inline T TN_Zero(){
+	T zero;
+	zero = 0;
+	return zero;
+}
+
+//T, the cell type, holding cell i of an expression
+template<class T, class expr>
+inline T TN_CellAt(const expr &expression, TN_Index i){
+	T cell;
+	cell = expression.calc(i);
+	return cell;
+}
+
+/*Cells of a row of scalars are accumulated into TN_REDUCELANES partial results, cell i into
+lane i % TN_REDUCELANES, which the compiler keeps in vector registers. Unlike an OpenMP SIMD
+reduction, this vectorises inside parallel regions and without -ffast-math, and sums each row
+in the same order every time.*/
+static constexpr int TN_REDUCELANES = 8;
+
+template<class T, class func, class joinfunc>
+inline void TN_ReduceLanes(T &partial, const T &identity, TN_Index begin, TN_Index end, func f, joinfunc join){
+	T lanes[TN_REDUCELANES];
+	for(int l=0; l < TN_REDUCELANES; ++l)
+		lanes[l] = identity;
+	TN_Index i = begin;
+	for(; i + TN_REDUCELANES <= end; i += TN_REDUCELANES){
+		for(int l=0; l < TN_REDUCELANES; ++l)
+			join(lanes[l], f(i + l));
+	}
+	for(; i < end; ++i){
+		join(lanes[0], f(i));
+	}
+	for(int l=0; l < TN_REDUCELANES; ++l)
+		join(partial, lanes[l]);
+}
+
+//Sums
+//****
+
+//sum of f(i) over the cells i of expression, where f also reads any other operands
+template<class T, class expr, class func, class... others>
+inline T TN_SumCells(const expr &expression, func f, const others &... operands){
+	return TN_ReduceCells(expression, TN_Zero<T>(),
+		[&](T &partial, TN_Index begin, TN_Index end){
+			if constexpr (std::is_arithmetic_v<T>){
+				TN_ReduceLanes(partial, T(0), begin, end, f, [](T &a, const T &b){ a += b; });
+			}else{
+				for(TN_Index i=begin; i < end; ++i){
+					partial += f(i);
+				}
+			}
+		},
+		[](T &result, const T &partial){ result += partial; }, operands...);
+}
+
+//sum of every cell, a datatype, or a matrix for arrays of matrices
+template<class expr, std::enable_if_t<TN_HasExtent<expr>::value, int> = 0>
+inline auto sum(const expr &expression){
+	typedef typename TN_CellType<expr>::type celltype;
+	return TN_SumCells<celltype>(expression, [&](TN_Index i){ return expression.calc(i); });
+}
+
+template<class expr, std::enable_if_t<TN_HasExtent<expr>::value, int> = 0>
+inline auto mean(const expr &expression){
+	typedef typename TN_CellType<expr>::type celltype;
+	celltype total = sum(expression);
+	total /= typename TN_ScalarType<expr>::type(TN_GetExtent(expression).get_ncells());
+	return total;
+}
+
+/*sum over the cells of a*b, and for arrays of matrices over every component, i.e. the
+Frobenius inner product of each pair of cells*/
+template<class lhs, class rhs, std::enable_if_t<TN_HasExtent<lhs>::value && TN_HasExtent<rhs>::value, int> = 0>
+inline auto dot(const lhs &A, const rhs &B){
+	typedef typename TN_ScalarType<lhs>::type datatype;
+	if constexpr (TN_IsMatrixValued<TN_ArrayOperand<lhs> >::value){
+		typedef typename TN_CellType<lhs>::type celltype;
+		return TN_SumCells<datatype>(A, [&](TN_Index i){
+			datatype cellsum = 0;
+			auto a = A.calc(i);
+			auto b = B.calc(i);
+			for(int c=0; c < celltype().get_ntot(); ++c)
+				cellsum += a.calc(c)*b.calc(c);
+			return cellsum;
+		}, B);
+	}else{
+		return TN_SumCells<datatype>(A, [&](TN_Index i){ return A.calc(i)*B.calc(i); }, B);
+	}
+}
+
+//the 2-norm, over every component for arrays of matrices
+template<class expr, std::enable_if_t<TN_HasExtent<expr>::value, int> = 0>
+inline auto norm(const expr &expression){
+	typedef typename TN_ScalarType<expr>::type datatype;
+	if constexpr (TN_IsMatrixValued<TN_ArrayOperand<expr> >::value){
+		typedef typename TN_CellType<expr>::type celltype;
+		return std::sqrt(TN_SumCells<datatype>(expression, [&](TN_Index i){
+			datatype cellsum = 0;
+			auto cell = expression.calc(i);
+			for(int c=0; c < celltype().get_ntot(); ++c)
+				cellsum += cell.calc(c)*cell.calc(c);
+			return cellsum;
+		}));
+	}else{
+		return std::sqrt(TN_SumCells<datatype>(expression, [&](TN_Index i){
+			datatype value = expression.calc(i);
+			return value*value;
+		}));
+	}
+}
+
+//Extremes
+//********
+
+/*index of the least cell, or with greatest the greatest, of cell type T. Matrix cells are
+ordered by their least, or greatest, component, as by TN_Matrix's < and >.*/
+template<class T, bool greatest, class expr>
+inline TN_Index TN_ArgExtreme(const expr &expression){
+	struct candidate{
+		T m_value;
+		TN_Index m_index;
+	};
+	auto better = [](const T &a, TN_Index ia, const T &b, TN_Index ib){
+		if constexpr (greatest)
+			return a > b || (!(b > a) && ia < ib);
+		else
+			return a < b || (!(b < a) && ia < ib);
+	};
+	candidate first{TN_CellAt<T>(expression, 0), 0};
+	candidate best = TN_ReduceCells(expression, first,
+		[&](candidate &partial, TN_Index begin, TN_Index end){
+			for(TN_Index i=begin; i < end; ++i){
+				T cell = TN_CellAt<T>(expression, i);
+				if(better(cell, i, partial.m_value, partial.m_index)){
+					partial.m_value = cell;
+					partial.m_index = i;
+				}
+			}
+		},
+		[&](candidate &result, const candidate &partial){
+			if(better(partial.m_value, partial.m_index, result.m_value, result.m_index))
+				result = partial;
+		});
+	return best.m_index;
+}
+
+//the least, or greatest, cell; for scalars reduced in lanes
+template<class T, bool greatest, class expr>
+inline T TN_ExtremeCell(const expr &expression){
+	if constexpr (std::is_arithmetic_v<T>){
+		auto extreme = [](T &result, const T &cell){
+			if constexpr (greatest)
+				result = (cell > result) ? cell : result;
+			else
+				result = (cell < result) ? cell : result;
+		};
+		T first = expression.calc(0);
+		return TN_ReduceCells(expression, first,
+			[&](T &partial, TN_Index begin, TN_Index end){
+				TN_ReduceLanes(partial, first, begin, end, [&](TN_Index i){ return T(expression.calc(i)); }, extreme);
+			},
+			extreme);
+	}else{
+		return TN_CellAt<T>(expression, TN_ArgExtreme<T, greatest>(expression));
+	}
+}
+
+template<class expr, std::enable_if_t<TN_HasExtent<expr>::value, int> = 0>
+inline auto min(const expr &expression){
+	return TN_ExtremeCell<typename TN_CellType<expr>::type, false>(expression);
+}
+
+template<class expr, std::enable_if_t<TN_HasExtent<expr>::value, int> = 0>
+inline auto max(const expr &expression){
+	return TN_ExtremeCell<typename TN_CellType<expr>::type, true>(expression);
+}
+
+//flat index of the least or greatest cell, as taken by calc(i) and array(i)
+template<class expr, std::enable_if_t<TN_HasExtent<expr>::value, int> = 0>
+inline TN_Index argmin(const expr &expression){
+	return TN_ArgExtreme<typename TN_CellType<expr>::type, false>(expression);
+}
+
+template<class expr, std::enable_if_t<TN_HasExtent<expr>::value, int> = 0>
+inline TN_Index argmax(const expr &expression){
+	return TN_ArgExtreme<typename TN_CellType<expr>::type, true>(expression);
+}
+
+#endif //TN_REDUCE
@@ -0,0 +1,291 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//***************
+//class TN_Packet
+//***************
+//explicit SIMD evaluation of array expressions, a packet of cells at a time, with the
+//instruction set chosen at run time.
+
+#ifndef TN_SIMD
+#define TN_SIMD
+
+#include <type_traits>
+
+/*Assignments of expressions over arrays of doubles or floats are evaluated a packet of cells
+at a time through calc_packet(), which AddOp, SubOp, MulOp and DivOp provide alongside calc().
+The packet width is chosen at run time from the widest instruction set the processor supports:
+64 bytes with AVX-512, 32 with AVX2, and otherwise 16, i.e. SSE2 or the native vectors of other
+processors. Each row is evaluated in whole packets, and the cells left at its end one at a
+time. The packet path needs the vector extensions of GCC or Clang; #define TN_NOSIMD to leave it
+out and evaluate every expression cell by cell.*/
+#if !defined(__GNUC__) && !defined(TN_NOSIMD)
+	#define TN_NOSIMD
+#endif
+
+enum TN_SimdLevel {TN_SIMDNONE, TN_SIMDSSE2, TN_SIMDAVX2, TN_SIMDAVX512};
+
+//widest packets the processor supports
+inline TN_SimdLevel TN_SimdSupported(){
+	#ifdef TN_NOSIMD
+		return TN_SIMDNONE;
+	#else
+		#if defined(__x86_64__) || defined(__i386__)
+			__builtin_cpu_init();
+			if(__builtin_cpu_supports("avx512f"))
+				return TN_SIMDAVX512;
+			if(__builtin_cpu_supports("avx2"))
+				return TN_SIMDAVX2;
+		#endif
+		return TN_SIMDSSE2;
+	#endif
+};
+
+//packets used by the assignment loops, set from the processor on first use
+inline TN_SimdLevel &TN_SimdSetting(){
+	static TN_SimdLevel level = TN_SimdSupported();
+	return level;
+};
+
+inline TN_SimdLevel TN_GetSimdLevel(){
+	return TN_SimdSetting();
+};
+
+/*Lower the packet width, e.g. to TN_SIMDNONE to compare against cell-by-cell evaluation.
+Levels the processor does not support are capped to the widest it does. Set it before any
+parallel assignment starts.*/
+inline void TN_SetSimdLevel(TN_SimdLevel level){
+	TN_SimdLevel supported = TN_SimdSupported();
+	TN_SimdSetting() = (level < supported) ? level : supported;
+};
+
+/*TN_HasPacket<Op>::value is true for operations that provide calc_packet(), and
+TN_IsPacketExpr<expr>::value for arrays of doubles or floats, and for expressions built from
+them and from scalars by such operations alone; only these are evaluated in packets.*/
+template<class Op>
+struct TN_HasPacket : std::false_type {};
+
+template<class T>
+struct TN_IsPacketExpr : std::false_type {};
+
+#ifndef TN_NOSIMD
+
+template<class datatype>
+struct TN_IsPacketType : std::bool_constant<std::is_same_v<datatype, double> || std::is_same_v<datatype, float> > {};
+
+template<class datatype>
+struct TN_IsPacketExpr<TN_Array<datatype, TN_AlignedAllocator<datatype> > > : TN_IsPacketType<datatype> {};
+
+template<class T, class datatype>
+struct TN_IsPacketOperand : std::bool_constant<std::is_same_v<T, datatype> || TN_IsPacketExpr<T>::value> {};
+
+template<class LHS, class Op, class RHS, class datatype>
+struct TN_IsPacketExpr<ArrBinExpr<LHS, Op, RHS, datatype> > :
+	std::bool_constant<TN_IsPacketType<datatype>::value && TN_HasPacket<Op>::value &&
+		TN_IsPacketOperand<LHS, datatype>::value && TN_IsPacketOperand<RHS, datatype>::value> {};
+
+/*A packet of width cells, held in a vector register. The register is wrapped in a struct so
+that packets passed between the calc_packet() functions, which are compiled for whatever the
+build flags target, do not depend on the calling convention of a wider instruction set; once
+the calc_packet() functions are inlined into an assignment kernel the packets never leave the
+registers.*/
+template<class datatype, int width>
+struct TN_Packet{
+
+	typedef datatype vector __attribute__((vector_size(width*sizeof(datatype))));
+
+	vector m_v;
+
+	//width cells from p on, which need not be aligned
+	static inline TN_Packet load(const datatype *p){
+		TN_Packet packet;
+		__builtin_memcpy(&packet.m_v, p, sizeof(vector));
+		return packet;
+	};
+
+	inline void store(datatype *p) const {
+		__builtin_memcpy(p, &m_v, sizeof(vector));
+	};
+
+	//every cell x
+	static inline TN_Packet broadcast(const datatype &x){
+		return TN_Packet{vector{} + x};
+	};
+
+	//cell by cell, a where mask, the result of comparing two vectors, is set and otherwise b
+	template<class mask>
+	static inline TN_Packet select(const mask &m, const TN_Packet &a, const TN_Packet &b){
+		return TN_Packet{m ? a.m_v : b.m_v};
+	}
+
+	friend inline TN_Packet operator + (const TN_Packet &a, const TN_Packet &b){
+		return TN_Packet{a.m_v + b.m_v};
+	};
+
+	friend inline TN_Packet operator - (const TN_Packet &a, const TN_Packet &b){
+		return TN_Packet{a.m_v - b.m_v};
+	};
+
+	friend inline TN_Packet operator * (const TN_Packet &a, const TN_Packet &b){
+		return TN_Packet{a.m_v * b.m_v};
+	};
+
+	friend inline TN_Packet operator / (const TN_Packet &a, const TN_Packet &b){
+		return TN_Packet{a.m_v / b.m_v};
+	};
+
+	friend inline TN_Packet operator - (const TN_Packet &a){
+		return TN_Packet{-a.m_v};
+	};
+
+	//scalars are broadcast to every cell
+	friend inline TN_Packet operator + (const datatype &a, const TN_Packet &b){
+		return TN_Packet{a + b.m_v};
+	};
+
+	friend inline TN_Packet operator + (const TN_Packet &a, const datatype &b){
+		return TN_Packet{a.m_v + b};
+	};
+
+	friend inline TN_Packet operator - (const datatype &a, const TN_Packet &b){
+		return TN_Packet{a - b.m_v};
+	};
+
+	friend inline TN_Packet operator - (const TN_Packet &a, const datatype &b){
+		return TN_Packet{a.m_v - b};
+	};
+
+	friend inline TN_Packet operator * (const datatype &a, const TN_Packet &b){
+		return TN_Packet{a * b.m_v};
+	};
+
+	friend inline TN_Packet operator * (const TN_Packet &a, const datatype &b){
+		return TN_Packet{a.m_v * b};
+	};
+
+	friend inline TN_Packet operator / (const datatype &a, const TN_Packet &b){
+		return TN_Packet{a / b.m_v};
+	};
+
+	friend inline TN_Packet operator / (const TN_Packet &a, const datatype &b){
+		return TN_Packet{a.m_v / b};
+	};
+};
+
+//Assignment kernels
+//******************
+
+//cells [begin,end) of out = expression, width cells at a time, then the remainder one at a time
+template<int width, class datatype, class expr>
+inline void TN_AssignPackets(datatype *out, const expr &expression, TN_Index begin, TN_Index end){
+	TN_Index i = begin;
+	for(; i + width <= end; i += width){
+		expression.template calc_packet<width>(i).store(out + i);
+	}
+	for(; i < end; ++i){
+		out[i] = expression.calc(i);
+	}
+};
+
+/*rows [begin,end) of out = expression, for arrays of rows of nz cells nzpad apart, each with
+the expression rebuilt with its views bound to the row, see TN_BindRow() in TN_ArrayView.h*/
+template<int width, class datatype, class expr>
+inline void TN_AssignRowPackets(datatype *out, const expr &expression, TN_Index begin, TN_Index end,
+		TN_Index nz, TN_Index nzpad){
+	for(TN_Index row=begin; row < end; ++row){
+		TN_AssignPackets<width>(out, TN_BindRow(expression, row), row*nzpad, row*nzpad + nz);
+	}
+};
+
+/*One kernel per instruction set, each compiled for it whatever the build flags. flatten inlines
+the whole expression tree into the kernel, so its packets never leave the vector registers.*/
+template<class datatype, class expr>
+__attribute__((flatten))
+void TN_AssignSSE2(datatype *out, const expr &expression, TN_Index begin, TN_Index end){
+	TN_AssignPackets<16/sizeof(datatype)>(out, expression, begin, end);
+};
+
+template<class datatype, class expr>
+__attribute__((flatten))
+void TN_AssignRowsSSE2(datatype *out, const expr &expression, TN_Index begin, TN_Index end,
+		TN_Index nz, TN_Index nzpad){
+	TN_AssignRowPackets<16/sizeof(datatype)>(out, expression, begin, end, nz, nzpad);
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+template<class datatype, class expr>
+__attribute__((target("avx2"), flatten))
+void TN_AssignAVX2(datatype *out, const expr &expression, TN_Index begin, TN_Index end){
+	TN_AssignPackets<32/sizeof(datatype)>(out, expression, begin, end);
+};
+
+template<class datatype, class expr>
+__attribute__((target("avx2"), flatten))
+void TN_AssignRowsAVX2(datatype *out, const expr &expression, TN_Index begin, TN_Index end,
+		TN_Index nz, TN_Index nzpad){
+	TN_AssignRowPackets<32/sizeof(datatype)>(out, expression, begin, end, nz, nzpad);
+};
+
+template<class datatype, class expr>
+__attribute__((target("avx512f"), flatten))
+void TN_AssignAVX512(datatype *out, const expr &expression, TN_Index begin, TN_Index end){
+	TN_AssignPackets<64/sizeof(datatype)>(out, expression, begin, end);
+};
+
+template<class datatype, class expr>
+__attribute__((target("avx512f"), flatten))
+void TN_AssignRowsAVX512(datatype *out, const expr &expression, TN_Index begin, TN_Index end,
+		TN_Index nz, TN_Index nzpad){
+	TN_AssignRowPackets<64/sizeof(datatype)>(out, expression, begin, end, nz, nzpad);
+};
+
+#endif
+
+template<class datatype, class expr>
+using TN_AssignKernel = void (*)(datatype *, const expr &, TN_Index, TN_Index);
+
+template<class datatype, class expr>
+using TN_AssignRowKernel = void (*)(datatype *, const expr &, TN_Index, TN_Index, TN_Index, TN_Index);
+
+//kernel for the current TN_SimdLevel, looked up once per assignment
+template<class datatype, class expr>
+inline TN_AssignKernel<datatype, expr> TN_PacketKernel(){
+	#if defined(__x86_64__) || defined(__i386__)
+		switch(TN_GetSimdLevel()){
+			case TN_SIMDAVX512:
+				return &TN_AssignAVX512<datatype, expr>;
+			case TN_SIMDAVX2:
+				return &TN_AssignAVX2<datatype, expr>;
+			default:
+				break;
+		}
+	#endif
+	return &TN_AssignSSE2<datatype, expr>;
+};
+
+//row kernel for the current TN_SimdLevel, for expressions that read views
+template<class datatype, class expr>
+inline TN_AssignRowKernel<datatype, expr> TN_PacketRowKernel(){
+	#if defined(__x86_64__) || defined(__i386__)
+		switch(TN_GetSimdLevel()){
+			case TN_SIMDAVX512:
+				return &TN_AssignRowsAVX512<datatype, expr>;
+			case TN_SIMDAVX2:
+				return &TN_AssignRowsAVX2<datatype, expr>;
+			default:
+				break;
+		}
+	#endif
+	return &TN_AssignRowsSSE2<datatype, expr>;
+};
+
+//cells of an unpadded array handed to the kernel at a time, a multiple of every packet width
+static constexpr TN_Index TN_PACKETBLOCK = 1024;
+
+#endif //TN_NOSIMD
+
+#endif //TN_SIMD
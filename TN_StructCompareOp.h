@@ -0,0 +1,320 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+#ifndef TN_STRUCTCOMPAREOP
+#define TN_STRUCTCOMPAREOP
+
+#include <type_traits>
+
+/*
+Comparisons give masks, of 1 where they hold and 0 where they do not, in the datatype of their
+operands, cell by cell, or for arrays of matrices component by component. where(mask, a, b)
+is held as two nodes, (mask SelectOp a) ElseOp b, so that it needs no node of three operands:
+SelectOp gives a where the mask is not 0 and otherwise 0, and ElseOp reads the mask and a back
+out of it to give a where the mask is not 0 and otherwise b. Neither branches; packets choose
+with a blend. Operands may be scalars, arrays, views, tiled arrays, arrays of matrices and
+expressions of them, and beside arrays of matrices, matrices. At the level of arrays of
+matrices, calc() builds the node that does the same to the cells' matrix expressions, e.g.
+template<any templated params>
+static inline auto calc(const arrmat &A, const datatype &B, TN_Index i){
+		return MatBinExpr<TN_Matrix<datatype, nrows, ncols>, _OPNAME, datatype, ...>(A.calc(i), B);
+	}
+*/
+
+//Operand traits
+//**************
+
+//rows and columns of the matrix cells of T, or 0 for scalars and arrays of them
+template <class T>
+struct TN_MatrixShape
+{
+	static constexpr int nrows = 0;
+	static constexpr int ncols = 0;
+};
+
+template <class datatype, int r, int c>
+struct TN_MatrixShape<TN_Matrix<datatype, r, c> >
+{
+	static constexpr int nrows = r;
+	static constexpr int ncols = c;
+};
+
+template <class lhs, class op, class rhs, int r, int c, class datatype>
+struct TN_MatrixShape<MatBinExpr<lhs, op, rhs, r, c, datatype> >
+{
+	static constexpr int nrows = r;
+	static constexpr int ncols = c;
+};
+
+template <class datatype, int r, int c, class allocator>
+struct TN_MatrixShape<TN_Array<TN_Matrix<datatype, r, c>, allocator> >
+{
+	static constexpr int nrows = r;
+	static constexpr int ncols = c;
+};
+
+template <class lhs, class op, class rhs, int r, int c, class rtn>
+struct TN_MatrixShape<ArrMatBinExpr<lhs, op, rhs, r, c, rtn> >
+{
+	static constexpr int nrows = r;
+	static constexpr int ncols = c;
+};
+
+//shape of the first of several operands with matrix cells, taking derived arrays as the arrays they are
+template <class T, class... rest>
+struct TN_CellShape : std::conditional_t<TN_MatrixShape<TN_ArrayOperand<T> >::nrows != 0, TN_MatrixShape<TN_ArrayOperand<T> >, TN_CellShape<rest...> > {};
+
+template <class T>
+struct TN_CellShape<T> : TN_MatrixShape<TN_ArrayOperand<T> > {};
+
+//datatype of the first of several operands that is not a scalar
+template <class T, class... rest>
+struct TN_OperandScalar : std::conditional_t<std::is_arithmetic_v<T>, TN_OperandScalar<rest...>, TN_ScalarType<T> > {};
+
+template <class T>
+struct TN_OperandScalar<T> : std::conditional_t<std::is_arithmetic_v<T>, std::type_identity<T>, TN_ScalarType<T> > {};
+
+//arrays and array expressions whose cells are matrices
+template <class T>
+struct TN_IsMatrixArray : std::bool_constant<TN_HasExtent<T>::value && TN_IsMatrixValued<TN_ArrayOperand<T> >::value> {};
+
+//an operand's cell i, or if it is the same in every cell, e.g. a scalar or matrix, itself
+template <class T>
+inline decltype(auto) TN_CellOf(const T &operand, TN_Index i)
+{
+	if constexpr (TN_HasExtent<T>::value)
+		return operand.calc(i);
+	else
+		return (operand);
+}
+
+template <class T>
+using TN_CellExpr = std::decay_t<decltype(TN_CellOf(std::declval<const T &>(), TN_Index(0)))>;
+
+//an operand's scalar i, its cell of an array or component of a matrix, or if a scalar itself
+template <class T>
+inline decltype(auto) TN_ValueAt(const T &operand, TN_Index i)
+{
+	if constexpr (std::is_arithmetic_v<T>)
+		return (operand);
+	else
+		return operand.calc(i);
+}
+
+#ifndef TN_NOSIMD
+//an operand's packet of cells from i on, with scalars broadcast
+template <int width, class datatype, class T>
+inline auto TN_PacketAt(const T &operand, TN_Index i)
+{
+	if constexpr (std::is_arithmetic_v<T>)
+		return TN_Packet<datatype, width>::broadcast(operand);
+	else
+		return operand.template calc_packet<width>(i);
+}
+#endif
+
+/*the node applying Op to A and B: a matrix expression if either has matrix cells of shape
+nrows x ncols and neither has an extent, otherwise an array expression, of matrices if nrows
+is not 0, whose cells are the nodes Op builds from the operands' cells. Arrays derived from TN_Array,
+e.g. TN_MappedArray, are held as the TN_Array they are, by reference like any other array.*/
+template <class Op, int nrows, int ncols, class L, class R>
+static inline auto TN_CellwiseNode(const L &A, const R &B)
+{
+	typedef TN_ArrayOperand<L> lhs;
+	typedef TN_ArrayOperand<R> rhs;
+	typedef typename TN_OperandScalar<lhs, rhs>::type datatype;
+	if constexpr (nrows == 0)
+		return ArrBinExpr<lhs, Op, rhs, datatype>(A, B);
+	else if constexpr (TN_HasExtent<lhs>::value || TN_HasExtent<rhs>::value)
+		return ArrMatBinExpr<lhs, Op, rhs, nrows, ncols,
+							 MatBinExpr<TN_CellExpr<lhs>, Op, TN_CellExpr<rhs>, nrows, ncols, datatype> >(A, B);
+	else
+		return MatBinExpr<lhs, Op, rhs, nrows, ncols, datatype>(A, B);
+}
+
+//Comparisons
+//***********
+
+template <class Fn>
+struct CompareOp
+{
+	//1 where the comparison holds, otherwise 0, or for arrays of matrices the cell's mask
+	template <class L, class R>
+	static inline auto calc(const L &A, const R &B, TN_Index i)
+	{
+		if constexpr (TN_IsMatrixArray<L>::value || TN_IsMatrixArray<R>::value){
+			typedef TN_CellShape<L, R> shape;
+			return TN_CellwiseNode<Fn, shape::nrows, shape::ncols>(TN_CellOf(A, i), TN_CellOf(B, i));
+		}else{
+			typedef typename TN_OperandScalar<L, R>::type datatype;
+			return Fn::apply(datatype(TN_ValueAt(A, i)), datatype(TN_ValueAt(B, i)));
+		}
+	}
+
+	//Packets
+	//*******
+
+	#ifndef TN_NOSIMD
+	//array or ArrBinExpr op array, ArrBinExpr or datatype
+	template <int width, class L, class R>
+	static inline auto calc_packet(const L &A, const R &B, TN_Index i)
+	{
+		typedef typename TN_OperandScalar<L, R>::type datatype;
+		return Fn::template apply_packet<width>(TN_PacketAt<width, datatype>(A, i), TN_PacketAt<width, datatype>(B, i));
+	}
+
+	//1 in the cells where m is set, otherwise 0
+	template <int width, class datatype, class mask>
+	static inline auto packet_mask(const mask &m)
+	{
+		typedef TN_Packet<datatype, width> packet;
+		return packet::select(m, packet::broadcast(1), packet::broadcast(0));
+	}
+	#endif
+};
+
+//a < b
+struct LtOp : CompareOp<LtOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &a, const datatype &b){
+		return a < b ? 1 : 0;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &a, const TN_Packet<datatype, width> &b){
+		return packet_mask<width, datatype>(a.m_v < b.m_v);
+	}
+	#endif
+};
+
+//a <= b
+struct LeOp : CompareOp<LeOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &a, const datatype &b){
+		return a <= b ? 1 : 0;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &a, const TN_Packet<datatype, width> &b){
+		return packet_mask<width, datatype>(a.m_v <= b.m_v);
+	}
+	#endif
+};
+
+//a > b
+struct GtOp : CompareOp<GtOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &a, const datatype &b){
+		return a > b ? 1 : 0;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &a, const TN_Packet<datatype, width> &b){
+		return packet_mask<width, datatype>(a.m_v > b.m_v);
+	}
+	#endif
+};
+
+//a >= b
+struct GeOp : CompareOp<GeOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &a, const datatype &b){
+		return a >= b ? 1 : 0;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &a, const TN_Packet<datatype, width> &b){
+		return packet_mask<width, datatype>(a.m_v >= b.m_v);
+	}
+	#endif
+};
+
+//Select
+//******
+
+//a where the mask is not 0, otherwise 0
+struct SelectOp
+{
+	template <class M, class L>
+	static inline auto calc(const M &A, const L &B, TN_Index i)
+	{
+		if constexpr (TN_IsMatrixArray<M>::value || TN_IsMatrixArray<L>::value){
+			typedef TN_CellShape<M, L> shape;
+			return TN_CellwiseNode<SelectOp, shape::nrows, shape::ncols>(TN_CellOf(A, i), TN_CellOf(B, i));
+		}else{
+			typedef typename TN_OperandScalar<M, L>::type datatype;
+			return (TN_ValueAt(A, i) != 0) ? datatype(TN_ValueAt(B, i)) : datatype(0);
+		}
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class M, class L>
+	static inline auto calc_packet(const M &A, const L &B, TN_Index i)
+	{
+		typedef typename TN_OperandScalar<M, L>::type datatype;
+		typedef TN_Packet<datatype, width> packet;
+		return packet::select(TN_PacketAt<width, datatype>(A, i).m_v != 0,
+			TN_PacketAt<width, datatype>(B, i), packet::broadcast(0));
+	}
+	#endif
+};
+
+//a where the mask is not 0, otherwise b
+struct ElseOp
+{
+	template <class S, class R>
+	static inline auto calc(const S &A, const R &B, TN_Index i)
+	{
+		if constexpr (TN_IsMatrixArray<S>::value || TN_IsMatrixArray<R>::value){
+			typedef TN_CellShape<S, R> shape;
+			return TN_CellwiseNode<ElseOp, shape::nrows, shape::ncols>(
+				TN_CellwiseNode<SelectOp, shape::nrows, shape::ncols>(TN_CellOf(A.left(), i), TN_CellOf(A.right(), i)),
+				TN_CellOf(B, i));
+		}else{
+			typedef typename TN_OperandScalar<S, R>::type datatype;
+			return (TN_ValueAt(A.left(), i) != 0) ? datatype(TN_ValueAt(A.right(), i)) : datatype(TN_ValueAt(B, i));
+		}
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class S, class R>
+	static inline auto calc_packet(const S &A, const R &B, TN_Index i)
+	{
+		typedef typename TN_OperandScalar<S, R>::type datatype;
+		auto mask = TN_PacketAt<width, datatype>(A.left(), i);
+		return TN_Packet<datatype, width>::select(mask.m_v != 0,
+			TN_PacketAt<width, datatype>(A.right(), i), TN_PacketAt<width, datatype>(B, i));
+	}
+	#endif
+};
+
+template<>
+struct TN_HasPacket<LtOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<LeOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<GtOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<GeOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<SelectOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<ElseOp> : std::true_type {};
+
+#endif //TN_STRUCTCOMPAREOP
@@ -12,7 +12,7 @@ TUNGSTEN Arrays of matrices
 /*
 All operators are of the pattern:
 template<any templated params>
-static inline auto calc(const type1 &A, const type2 &B, int i){
+static inline auto calc(const type1 &A, const type2 &B, TN_Index i){
 		return A.calc(i) _OPSYMB B.calc(i);
 	}
 */
@@ -26,7 +26,7 @@ struct DivOp
 	template <int nrows, int ncols, class datatype>
 	static inline auto calc(const datatype &A,
 								const TN_Matrix<datatype, nrows, ncols> &B,
-								int i)
+								TN_Index i)
 	{
 		return A / B.calc(i);
 	}
@@ -34,7 +34,7 @@ struct DivOp
 	//datatype op MatBinExpr
 	template <class datatype, class lhs, class op, class rhs, int nrows, int ncols>
 	static inline auto
-	calc(const datatype &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, int i)
+	calc(const datatype &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, TN_Index i)
 	{
 		return A / B.calc(i);
 	}
@@ -43,7 +43,7 @@ struct DivOp
 	template <class datatype>
 	static inline auto calc(const datatype &A,
 								const TN_Array<datatype> &B,
-								int i)
+								TN_Index i)
 	{
 		return A / B.calc(i);
 	}
@@ -51,7 +51,7 @@ struct DivOp
 	//datatype op ArrBinExpr
 	template <class datatype, class lhs, class op, class rhs>
 	static inline auto
-	calc(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, int i)
+	calc(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
 	{
 		return A / B.calc(i);
 	}
@@ -61,7 +61,7 @@ struct DivOp
 	static inline auto
 								calc(	const datatype &A,
 										const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B,
-										int i)
+										TN_Index i)
 	{
 		return A / B.calc(i);
 	}
@@ -71,7 +71,7 @@ struct DivOp
 	static inline auto
 								calc(	const datatype &A,
 										const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtntype> &B,
-										int i)
+										TN_Index i)
 	{
 		return A / B.calc(i);
 	}
@@ -83,7 +83,7 @@ struct DivOp
 	template <int nrows, int ncols, class datatype>
 	static inline auto calc(const TN_Matrix<datatype, nrows, ncols> &A,
 								const datatype &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) / B;
 	}
@@ -106,7 +106,7 @@ struct DivOp
 	//MatBinExpr op datatype
 	template <class lhs, class op, class rhs, int nrows, int ncols, class datatype>
 	static inline auto
-	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const datatype &B, int i)
+	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const datatype &B, TN_Index i)
 	{
 		return A.calc(i) / B;
 	}
@@ -131,7 +131,7 @@ struct DivOp
 	template <class datatype>
 	static inline auto calc(const TN_Array<datatype> &A,
 								const datatype &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) / B;
 	}
@@ -140,7 +140,7 @@ struct DivOp
 	template <class datatype>
 	static inline auto calc(const TN_Array<datatype> &A,
 								const TN_Array<datatype> &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -148,7 +148,7 @@ struct DivOp
 	//array op ArrBinExpr
 	template <class datatype, class lhs, class op, class rhs>
 	static inline auto
-	calc(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, int i)
+	calc(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -157,7 +157,7 @@ struct DivOp
 	template <class datatype,int nrows,int ncols>
 	static inline auto
 	calc(	const TN_Array<datatype> &A,
-			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B, int i)
+			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B, TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -167,7 +167,7 @@ struct DivOp
 	static inline auto
 	calc(	const TN_Array<datatype> &A,
 			const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -178,7 +178,7 @@ struct DivOp
 	//ArrBinExpr op datatype
 	template <class lhs, class op, class rhs, class datatype>
 	static inline auto
-	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, int i)
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, TN_Index i)
 	{
 		return A.calc(i) / B;
 	}
@@ -186,7 +186,7 @@ struct DivOp
 	//ArrBinExpr op array
 	template <class lhs, class op, class rhs, class datatype>
 	static inline auto
-	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, int i)
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -194,7 +194,7 @@ struct DivOp
 	//ArrBinExpr op ArrBinExpr
 	template <class lhs1, class op1, class rhs1, class datatype, class lhs2, class op2, class rhs2>
 	static inline auto
-	calc(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype>  &B, int i)
+	calc(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype>  &B, TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -204,7 +204,7 @@ struct DivOp
 	static inline auto
 	calc(	const ArrBinExpr<lhs,op,rhs,datatype> &A,
 			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -215,11 +215,133 @@ struct DivOp
 	static inline auto
 	calc(	const ArrBinExpr<lhs1,op1,rhs1,datatype> &A,
 			const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
 
+	//LHS or RHS TN_ArrayView
+	//***********************
+
+	//datatype op view
+	template <class datatype>
+	static inline auto
+	calc(const datatype &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A / B.calc(i);
+	}
+
+	//view op datatype
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.calc(i) / B;
+	}
+
+	//view op view
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//view op array
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//array op view
+	template <class datatype>
+	static inline auto
+	calc(const TN_Array<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//view op ArrBinExpr
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//ArrBinExpr op view
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//views with arrays of matrices not defined
+
+	//LHS or RHS TN_TiledArray
+	//************************
+
+	//datatype op tiled
+	template <class datatype>
+	static inline auto
+	calc(const datatype &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A / B.calc(i);
+	}
+
+	//tiled op datatype
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.calc(i) / B;
+	}
+
+	//tiled op tiled
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//tiled op array
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//array op tiled
+	template <class datatype>
+	static inline auto
+	calc(const TN_Array<datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//tiled op ArrBinExpr
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//ArrBinExpr op tiled
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) / B.calc(i);
+	}
+
+	//tiled arrays with views or arrays of matrices not defined
+
 	//LHS array<matrix>
 	//*****************
 
@@ -228,7 +350,7 @@ struct DivOp
 	static inline auto
 								calc(	const TN_Array<TN_Matrix<datatype, nrows, ncols> > &A,
 										const datatype &B,
-										int i)
+										TN_Index i)
 	{
 		return A.calc(i) / B;
 	}
@@ -241,7 +363,7 @@ struct DivOp
 	template <class datatype,int nrows,int ncols>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype,nrows,ncols> > &A,
-			const TN_Array<datatype> &B, int i)
+			const TN_Array<datatype> &B, TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -250,7 +372,7 @@ struct DivOp
 	template <class datatype,int nrows,int ncols,class lhs,class op,class rhs>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype,nrows,ncols> > &A,
-			const ArrBinExpr<lhs,op,rhs,datatype> &B, int i)
+			const ArrBinExpr<lhs,op,rhs,datatype> &B, TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -267,7 +389,7 @@ struct DivOp
 	static inline auto
 								calc(	const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtntype> &A,
 										const datatype &B,
-										int i)
+										TN_Index i)
 	{
 		return A.calc(i) / B;
 	}
@@ -281,7 +403,7 @@ struct DivOp
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &A,
 			const TN_Array<datatype> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -292,7 +414,7 @@ struct DivOp
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &A,
 			const ArrBinExpr<lhs1,op1,rhs1,datatype> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) / B.calc(i);
 	}
@@ -301,6 +423,136 @@ struct DivOp
 
 	//ArrMatBinExpr op ArrMatBinExpr not defined
 
+	//Packets
+	//*******
+
+	//calc_packet evaluates width cells at a time for arrays of doubles or floats, see TN_Simd.h
+
+	#ifndef TN_NOSIMD
+	//datatype op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const datatype &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A / B.template calc_packet<width>(i);
+	}
+
+	//datatype op ArrBinExpr
+	template <int width, class datatype, class lhs, class op, class rhs>
+	static inline auto
+	calc_packet(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A / B.template calc_packet<width>(i);
+	}
+
+	//array op datatype
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B;
+	}
+
+	//array op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//array op ArrBinExpr
+	template <int width, class datatype, class lhs, class op, class rhs>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op datatype
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B;
+	}
+
+	//ArrBinExpr op array
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op ArrBinExpr
+	template <int width, class lhs1, class op1, class rhs1, class datatype, class lhs2, class op2, class rhs2>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//datatype op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const datatype &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A / B.template calc_packet<width>(i);
+	}
+
+	//view op datatype
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B;
+	}
+
+	//view op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//view op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//array op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//view op ArrBinExpr
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op view
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) / B.template calc_packet<width>(i);
+	}
+	#endif
+
 };
 
+template<>
+struct TN_HasPacket<DivOp> : std::true_type {};
+
 #endif //STRUCTDIVOP
\ No newline at end of file
@@ -12,7 +12,7 @@ TUNGSTEN Arrays of matrices
 /*
 All calc's are of the pattern:
 template<any templated params>
-static inline auto calc(const type1 &A, const type2 &B, int i){
+static inline auto calc(const type1 &A, const type2 &B, TN_Index i){
 		return A.calc(i) _OPSYMB B.calc(i);
 	}
 */
@@ -26,7 +26,7 @@ struct MulOp
 	template <int nrows, int ncols, class datatype>
 	static inline auto calc(const datatype &A,
 								const TN_Matrix<datatype, nrows, ncols> &B,
-								int i)
+								TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -34,7 +34,7 @@ struct MulOp
 	//datatype op MatBinExpr
 	template <class datatype, class lhs, class op, class rhs, int nrows, int ncols>
 	static inline auto
-	calc(const datatype &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, int i)
+	calc(const datatype &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -43,7 +43,7 @@ struct MulOp
 	template <class datatype>
 	static inline auto calc(const datatype &A,
 								const TN_Array<datatype> &B,
-								int i)
+								TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -51,7 +51,7 @@ struct MulOp
 	//datatype op ArrBinExpr
 	template <class datatype, class lhs, class op, class rhs>
 	static inline auto
-	calc(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, int i)
+	calc(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -61,7 +61,7 @@ struct MulOp
 	static inline auto
 								calc(	const datatype &A,
 										const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B,
-										int i)
+										TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -71,7 +71,7 @@ struct MulOp
 	static inline auto
 								calc(	const datatype &A,
 										const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtntype> &B,
-										int i)
+										TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -83,7 +83,7 @@ struct MulOp
 	template <int nrows, int ncols, class datatype>
 	static inline auto calc(const TN_Matrix<datatype, nrows, ncols> &A,
 								const datatype &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -92,7 +92,7 @@ struct MulOp
 	template <int arows, int acols, int bcols, class datatype>
 	static inline auto calc(const TN_Matrix<datatype, arows, acols> &A,
 								const TN_Matrix<datatype, acols, bcols> &B,
-								int i)
+								TN_Index i)
 	{
 		datatype val = 0.0;
 		//reverse-lookup target row and column from i
@@ -107,7 +107,7 @@ struct MulOp
 	//matrix op MatBinExpr --- matrix multiply
 	template <class datatype, class lhs, class op, class rhs, int arows, int acols, int bcols>
 	static inline auto
-	calc(const TN_Matrix<datatype, arows, acols> &A, const MatBinExpr<lhs, op, rhs, acols, bcols, datatype> &B, int i)
+	calc(const TN_Matrix<datatype, arows, acols> &A, const MatBinExpr<lhs, op, rhs, acols, bcols, datatype> &B, TN_Index i)
 	{
 		datatype val = 0.0;
 		//reverse-lookup target row and column from i
@@ -127,7 +127,7 @@ struct MulOp
 	template <class datatype, int arows, int acols, int bcols>
 	static inline auto
 	calc(	const TN_Matrix<datatype, arows, acols> &A,
-			const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, int i)
+			const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -136,7 +136,7 @@ struct MulOp
 	template <class datatype, int arows, int acols, int bcols, class lhs, class op, class rhs, class rtntype>
 	static inline auto
 	calc(	const TN_Matrix<datatype, arows, acols> &A,
-			const ArrMatBinExpr<lhs, op, rhs, acols, bcols, rtntype> &B, int i)
+			const ArrMatBinExpr<lhs, op, rhs, acols, bcols, rtntype> &B, TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -147,7 +147,7 @@ struct MulOp
 	//MatBinExpr op datatype
 	template <class lhs, class op, class rhs, int nrows, int ncols, class datatype>
 	static inline auto
-	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const datatype &B, int i)
+	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const datatype &B, TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -155,7 +155,7 @@ struct MulOp
 	//MatBinExpr op matrix
 	template <class datatype, class lhs, class op, class rhs, int arows, int acols, int bcols>
 	static inline auto
-	calc(const MatBinExpr<lhs, op, rhs, arows, acols, datatype> &A, const TN_Matrix<datatype, acols, bcols> &B, int i)
+	calc(const MatBinExpr<lhs, op, rhs, arows, acols, datatype> &A, const TN_Matrix<datatype, acols, bcols> &B, TN_Index i)
 	{
 		datatype val = 0.0;
 		//reverse-lookup target row and column from i
@@ -171,7 +171,7 @@ struct MulOp
 	template <class datatype, class lhs1, class op1, class rhs1, class lhs2, class op2, class rhs2, int arows, int acols, int bcols>
 	static inline auto
 	calc(	const MatBinExpr<lhs1, op1, rhs1, arows, acols, datatype> &A,
-			const MatBinExpr<lhs2, op2, rhs2, acols, bcols, datatype> &B, int i)
+			const MatBinExpr<lhs2, op2, rhs2, acols, bcols, datatype> &B, TN_Index i)
 	{
 		datatype val = 0.0;
 		//reverse-lookup target row and column from i
@@ -191,7 +191,7 @@ struct MulOp
 	template <class lhs, class op, class rhs, int arows, int acols, int bcols, class datatype>
 	static inline auto
 	calc(	const MatBinExpr<lhs, op, rhs, arows, acols, datatype> &A,
-			const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, int i)
+			const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -201,7 +201,7 @@ struct MulOp
 		class lhs2, class op2, class rhs2, class rtn2 >
 	static inline auto
 		calc(	const MatBinExpr<lhs1,op1,rhs1,arows,acols,datatype> &A,
-				const ArrMatBinExpr<lhs2,op2,rhs2,acols,bcols,rtn2> &B, int i)
+				const ArrMatBinExpr<lhs2,op2,rhs2,acols,bcols,rtn2> &B, TN_Index i)
 	{
 		return A * B.calc(i);
 	}
@@ -214,7 +214,7 @@ struct MulOp
 	template <class datatype>
 	static inline auto calc(const TN_Array<datatype> &A,
 								const datatype &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -223,7 +223,7 @@ struct MulOp
 	template <class datatype>
 	static inline auto calc(const TN_Array<datatype> &A,
 								const TN_Array<datatype> &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -231,7 +231,7 @@ struct MulOp
 	//array op ArrBinExpr
 	template <class datatype, class lhs, class op, class rhs>
 	static inline auto
-	calc(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, int i)
+	calc(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -240,7 +240,7 @@ struct MulOp
 	template <class datatype,int nrows,int ncols>
 	static inline auto
 	calc(	const TN_Array<datatype> &A,
-			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B, int i)
+			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -250,7 +250,7 @@ struct MulOp
 	static inline auto
 	calc(	const TN_Array<datatype> &A,
 			const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -261,7 +261,7 @@ struct MulOp
 	//ArrBinExpr op datatype
 	template <class lhs, class op, class rhs, class datatype>
 	static inline auto
-	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, int i)
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -269,7 +269,7 @@ struct MulOp
 	//ArrBinExpr op array
 	template <class lhs, class op, class rhs, class datatype>
 	static inline auto
-	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, int i)
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -277,7 +277,7 @@ struct MulOp
 	//ArrBinExpr op ArrBinExpr
 	template <class lhs1, class op1, class rhs1, class datatype, class lhs2, class op2, class rhs2>
 	static inline auto
-	calc(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype>  &B, int i)
+	calc(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype>  &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -287,7 +287,7 @@ struct MulOp
 	static inline auto
 	calc(	const ArrBinExpr<lhs,op,rhs,datatype> &A,
 			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -298,11 +298,133 @@ struct MulOp
 	static inline auto
 	calc(	const ArrBinExpr<lhs1,op1,rhs1,datatype> &A,
 			const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
 
+	//LHS or RHS TN_ArrayView
+	//***********************
+
+	//datatype op view
+	template <class datatype>
+	static inline auto
+	calc(const datatype &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A * B.calc(i);
+	}
+
+	//view op datatype
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.calc(i) * B;
+	}
+
+	//view op view
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//view op array
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//array op view
+	template <class datatype>
+	static inline auto
+	calc(const TN_Array<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//view op ArrBinExpr
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//ArrBinExpr op view
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//views with arrays of matrices not defined
+
+	//LHS or RHS TN_TiledArray
+	//************************
+
+	//datatype op tiled
+	template <class datatype>
+	static inline auto
+	calc(const datatype &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A * B.calc(i);
+	}
+
+	//tiled op datatype
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.calc(i) * B;
+	}
+
+	//tiled op tiled
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//tiled op array
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//array op tiled
+	template <class datatype>
+	static inline auto
+	calc(const TN_Array<datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//tiled op ArrBinExpr
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//ArrBinExpr op tiled
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//tiled arrays with views or arrays of matrices not defined
+
 	//LHS array<matrix>
 	//*****************
 
@@ -311,7 +433,7 @@ struct MulOp
 	static inline auto
 								calc(	const TN_Array<TN_Matrix<datatype, nrows, ncols> > &A,
 										const datatype &B,
-										int i)
+										TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -320,7 +442,7 @@ struct MulOp
 	template <class datatype, int arows, int acols, int bcols>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype, arows, acols> > &A,
-			const TN_Matrix<datatype, acols, bcols> &B, int i)
+			const TN_Matrix<datatype, acols, bcols> &B, TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -329,7 +451,7 @@ struct MulOp
 	template <class datatype,int arows,int acols, int bcols, class lhs,class op,class rhs>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype, arows, acols> > &A,
-			const MatBinExpr<lhs,op,rhs,acols,bcols,datatype> &B, int i)
+			const MatBinExpr<lhs,op,rhs,acols,bcols,datatype> &B, TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -338,7 +460,7 @@ struct MulOp
 	template <class datatype,int nrows,int ncols>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype,nrows,ncols> > &A,
-			const TN_Array<datatype> &B, int i)
+			const TN_Array<datatype> &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -347,7 +469,7 @@ struct MulOp
 	template <class datatype,int nrows,int ncols,class lhs,class op,class rhs>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype,nrows,ncols> > &A,
-			const ArrBinExpr<lhs,op,rhs,datatype> &B, int i)
+			const ArrBinExpr<lhs,op,rhs,datatype> &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -356,7 +478,16 @@ struct MulOp
 	template <class datatype, int arows, int acols, int bcols>
 	static inline auto
 	calc(const TN_Array<TN_Matrix<datatype, arows, acols> > &A,
-		 const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, int i)
+		 const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, TN_Index i)
+	{
+		return A.calc(i) * B.calc(i);
+	}
+
+	//arrmat op arrmat, square, which array op array would otherwise match as well
+	template <class datatype, int n>
+	static inline auto
+	calc(const TN_Array<TN_Matrix<datatype, n, n> > &A,
+		 const TN_Array<TN_Matrix<datatype, n, n> > &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -365,7 +496,7 @@ struct MulOp
 	template <class datatype, class lhs, class op, class rhs, int arows, int acols, int bcols, class rtn>
 	static inline auto
 	calc(const TN_Array<TN_Matrix<datatype, arows, acols>> &A,
-		 const ArrMatBinExpr<lhs,op,rhs,acols,bcols,rtn> &B, int i)
+		 const ArrMatBinExpr<lhs,op,rhs,acols,bcols,rtn> &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -378,7 +509,7 @@ struct MulOp
 	static inline auto
 								calc(	const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtntype> &A,
 										const datatype &B,
-										int i)
+										TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -387,7 +518,7 @@ struct MulOp
 	template <class datatype, int arows, int acols, int bcols, class lhs, class op, class rhs, class rtntype>
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs, op, rhs, arows, acols, rtntype> &A,
-			const TN_Matrix<datatype, acols, bcols> &B, int i)
+			const TN_Matrix<datatype, acols, bcols> &B, TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -397,7 +528,7 @@ struct MulOp
 		class lhs2, class op2, class rhs2, class rtn2 >
 	static inline auto
 		calc(	const ArrMatBinExpr<lhs2,op2,rhs2,arows,acols,rtn2> &A,
-				const MatBinExpr<lhs1,op1,rhs1,acols,bcols,datatype> &B, int i)
+				const MatBinExpr<lhs1,op1,rhs1,acols,bcols,datatype> &B, TN_Index i)
 	{
 		return A.calc(i) * B;
 	}
@@ -407,7 +538,7 @@ struct MulOp
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &A,
 			const TN_Array<datatype> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -418,7 +549,7 @@ struct MulOp
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &A,
 			const ArrBinExpr<lhs1,op1,rhs1,datatype> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -427,7 +558,7 @@ struct MulOp
 	template <class datatype, class lhs, class op, class rhs, int arows, int acols, int bcols, class rtn>
 	static inline auto
 	calc(const ArrMatBinExpr<lhs,op,rhs,arows,acols,rtn> &A,
-		 const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, int i)
+		 const TN_Array<TN_Matrix<datatype, acols, bcols> > &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
@@ -437,11 +568,141 @@ struct MulOp
 	class lhs2,class op2,class rhs2,class mlhs2,class mop2,class mrhs2>
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs1,op1,rhs1,arows,acols,MatBinExpr<mlhs1,mop1,mrhs1,arows,acols,datatype> > &A,
-			const ArrMatBinExpr<lhs2,op2,rhs2,acols,bcols,MatBinExpr<mlhs2,mop2,mrhs2,acols,bcols,datatype> > &B, int i)
+			const ArrMatBinExpr<lhs2,op2,rhs2,acols,bcols,MatBinExpr<mlhs2,mop2,mrhs2,acols,bcols,datatype> > &B, TN_Index i)
 	{
 		return A.calc(i) * B.calc(i);
 	}
 
+	//Packets
+	//*******
+
+	//calc_packet evaluates width cells at a time for arrays of doubles or floats, see TN_Simd.h
+
+	#ifndef TN_NOSIMD
+	//datatype op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const datatype &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A * B.template calc_packet<width>(i);
+	}
+
+	//datatype op ArrBinExpr
+	template <int width, class datatype, class lhs, class op, class rhs>
+	static inline auto
+	calc_packet(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A * B.template calc_packet<width>(i);
+	}
+
+	//array op datatype
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B;
+	}
+
+	//array op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//array op ArrBinExpr
+	template <int width, class datatype, class lhs, class op, class rhs>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op datatype
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B;
+	}
+
+	//ArrBinExpr op array
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op ArrBinExpr
+	template <int width, class lhs1, class op1, class rhs1, class datatype, class lhs2, class op2, class rhs2>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//datatype op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const datatype &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A * B.template calc_packet<width>(i);
+	}
+
+	//view op datatype
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B;
+	}
+
+	//view op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//view op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//array op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//view op ArrBinExpr
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op view
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) * B.template calc_packet<width>(i);
+	}
+	#endif
+
 };
 
+template<>
+struct TN_HasPacket<MulOp> : std::true_type {};
+
 #endif //STRUCTMULOP
\ No newline at end of file
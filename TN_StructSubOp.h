@@ -12,7 +12,7 @@ TUNGSTEN Arrays of matrices
 /*
 All operators are of the pattern:
 template<any templated params>
-static inline auto calc(const type1 &A, const type2 &B, int i){
+static inline auto calc(const type1 &A, const type2 &B, TN_Index i){
 		return A.calc(i) _OPSYMB B.calc(i);
 	}
 */
@@ -26,7 +26,7 @@ struct SubOp
 	template <int nrows, int ncols, class datatype>
 	static inline auto calc(const datatype &A,
 								const TN_Matrix<datatype, nrows, ncols> &B,
-								int i)
+								TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -34,7 +34,7 @@ struct SubOp
 	//datatype op MatBinExpr
 	template <class datatype, class lhs, class op, class rhs, int nrows, int ncols>
 	static inline auto
-	calc(const datatype &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, int i)
+	calc(const datatype &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -43,7 +43,7 @@ struct SubOp
 	template <class datatype>
 	static inline auto calc(const datatype &A,
 								const TN_Array<datatype> &B,
-								int i)
+								TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -51,7 +51,7 @@ struct SubOp
 	//datatype op ArrBinExpr
 	template <class datatype, class lhs, class op, class rhs>
 	static inline auto
-	calc(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, int i)
+	calc(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -61,7 +61,7 @@ struct SubOp
 	static inline auto
 								calc(	const datatype &A,
 										const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B,
-										int i)
+										TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -71,7 +71,7 @@ struct SubOp
 	static inline auto
 								calc(	const datatype &A,
 										const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtntype> &B,
-										int i)
+										TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -83,7 +83,7 @@ struct SubOp
 	template <int nrows, int ncols, class datatype>
 	static inline auto calc(const TN_Matrix<datatype, nrows, ncols> &A,
 								const datatype &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -92,7 +92,7 @@ struct SubOp
 	template <int nrows, int ncols, class datatype>
 	static inline auto calc(const TN_Matrix<datatype, nrows, ncols> &A,
 								const TN_Matrix<datatype, nrows, ncols> &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -100,7 +100,7 @@ struct SubOp
 	//matrix op MatBinExpr
 	template <class datatype, class lhs, class op, class rhs, int nrows, int ncols>
 	static inline auto
-	calc(const TN_Matrix<datatype, nrows, ncols> &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, int i)
+	calc(const TN_Matrix<datatype, nrows, ncols> &A, const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -113,7 +113,7 @@ struct SubOp
 	template <class datatype, int nrows, int ncols>
 	static inline auto
 	calc(	const TN_Matrix<datatype, nrows, ncols> &A,
-			const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B, int i)
+			const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B, TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -122,7 +122,7 @@ struct SubOp
 	template <class datatype, int nrows, int ncols, class lhs, class op, class rhs, class rtntype>
 	static inline auto
 	calc(	const TN_Matrix<datatype, nrows, ncols> &A,
-			const ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtntype> &B, int i)
+			const ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtntype> &B, TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -133,7 +133,7 @@ struct SubOp
 	//MatBinExpr op datatype
 	template <class lhs, class op, class rhs, int nrows, int ncols, class datatype>
 	static inline auto
-	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const datatype &B, int i)
+	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const datatype &B, TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -141,7 +141,7 @@ struct SubOp
 	//MatBinExpr op matrix
 	template <class datatype, class lhs, class op, class rhs, int nrows, int ncols>
 	static inline auto
-	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const TN_Matrix<datatype, nrows, ncols> &B, int i)
+	calc(const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A, const TN_Matrix<datatype, nrows, ncols> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -150,7 +150,7 @@ struct SubOp
 	template <class datatype, class lhs1, class op1, class rhs1, class lhs2, class op2, class rhs2, int nrows, int ncols>
 	static inline auto
 	calc(	const MatBinExpr<lhs1, op1, rhs1, nrows, ncols, datatype> &A,
-			const MatBinExpr<lhs2, op2, rhs2, nrows, ncols, datatype> &B, int i)
+			const MatBinExpr<lhs2, op2, rhs2, nrows, ncols, datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -163,7 +163,7 @@ struct SubOp
 	template <class lhs, class op, class rhs, int nrows, int ncols, class datatype>
 	static inline auto
 	calc(	const MatBinExpr<lhs, op, rhs, nrows, ncols, datatype> &A,
-			const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B, int i)
+			const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B, TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -173,7 +173,7 @@ struct SubOp
 		class lhs2, class op2, class rhs2, class rtn2 >
 	static inline auto
 		calc(	const MatBinExpr<lhs1,op1,rhs1,nrows,ncols,datatype> &A,
-				const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &B, int i)
+				const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &B, TN_Index i)
 	{
 		return A - B.calc(i);
 	}
@@ -186,7 +186,7 @@ struct SubOp
 	template <class datatype>
 	static inline auto calc(const TN_Array<datatype> &A,
 								const datatype &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -195,7 +195,7 @@ struct SubOp
 	template <class datatype>
 	static inline auto calc(const TN_Array<datatype> &A,
 								const TN_Array<datatype> &B,
-								int i)
+								TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -203,7 +203,7 @@ struct SubOp
 	//array op ArrBinExpr
 	template <class datatype, class lhs, class op, class rhs>
 	static inline auto
-	calc(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, int i)
+	calc(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -212,7 +212,7 @@ struct SubOp
 	template <class datatype,int nrows,int ncols>
 	static inline auto
 	calc(	const TN_Array<datatype> &A,
-			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B, int i)
+			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -222,7 +222,7 @@ struct SubOp
 	static inline auto
 	calc(	const TN_Array<datatype> &A,
 			const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -233,7 +233,7 @@ struct SubOp
 	//ArrBinExpr op datatype
 	template <class lhs, class op, class rhs, class datatype>
 	static inline auto
-	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, int i)
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -241,7 +241,7 @@ struct SubOp
 	//ArrBinExpr op array
 	template <class lhs, class op, class rhs, class datatype>
 	static inline auto
-	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, int i)
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -249,7 +249,7 @@ struct SubOp
 	//ArrBinExpr op ArrBinExpr
 	template <class lhs1, class op1, class rhs1, class datatype, class lhs2, class op2, class rhs2>
 	static inline auto
-	calc(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype>  &B, int i)
+	calc(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype>  &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -259,7 +259,7 @@ struct SubOp
 	static inline auto
 	calc(	const ArrBinExpr<lhs,op,rhs,datatype> &A,
 			const TN_Array<TN_Matrix<datatype,nrows,ncols> > &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -270,11 +270,133 @@ struct SubOp
 	static inline auto
 	calc(	const ArrBinExpr<lhs1,op1,rhs1,datatype> &A,
 			const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
 
+	//LHS or RHS TN_ArrayView
+	//***********************
+
+	//datatype op view
+	template <class datatype>
+	static inline auto
+	calc(const datatype &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A - B.calc(i);
+	}
+
+	//view op datatype
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.calc(i) - B;
+	}
+
+	//view op view
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//view op array
+	template <class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//array op view
+	template <class datatype>
+	static inline auto
+	calc(const TN_Array<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//view op ArrBinExpr
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const TN_ArrayView<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//ArrBinExpr op view
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//views with arrays of matrices not defined
+
+	//LHS or RHS TN_TiledArray
+	//************************
+
+	//datatype op tiled
+	template <class datatype>
+	static inline auto
+	calc(const datatype &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A - B.calc(i);
+	}
+
+	//tiled op datatype
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.calc(i) - B;
+	}
+
+	//tiled op tiled
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//tiled op array
+	template <class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//array op tiled
+	template <class datatype>
+	static inline auto
+	calc(const TN_Array<datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//tiled op ArrBinExpr
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const TN_TiledArray<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//ArrBinExpr op tiled
+	template <class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_TiledArray<datatype> &B, TN_Index i)
+	{
+		return A.calc(i) - B.calc(i);
+	}
+
+	//tiled arrays with views or arrays of matrices not defined
+
 	//LHS array<matrix>
 	//*****************
 
@@ -283,7 +405,7 @@ struct SubOp
 	static inline auto
 								calc(	const TN_Array<TN_Matrix<datatype, nrows, ncols> > &A,
 										const datatype &B,
-										int i)
+										TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -292,7 +414,7 @@ struct SubOp
 	template <class datatype, int nrows, int ncols>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype, nrows, ncols> > &A,
-			const TN_Matrix<datatype, nrows, ncols> &B, int i)
+			const TN_Matrix<datatype, nrows, ncols> &B, TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -301,7 +423,7 @@ struct SubOp
 	template <class datatype,int nrows,int ncols,class lhs,class op,class rhs>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype, nrows, ncols> > &A,
-			const MatBinExpr<lhs,op,rhs,nrows,ncols,datatype> &B, int i)
+			const MatBinExpr<lhs,op,rhs,nrows,ncols,datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -310,7 +432,7 @@ struct SubOp
 	template <class datatype,int nrows,int ncols>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype,nrows,ncols> > &A,
-			const TN_Array<datatype> &B, int i)
+			const TN_Array<datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -319,7 +441,7 @@ struct SubOp
 	template <class datatype,int nrows,int ncols,class lhs,class op,class rhs>
 	static inline auto
 	calc(	const TN_Array<TN_Matrix<datatype,nrows,ncols> > &A,
-			const ArrBinExpr<lhs,op,rhs,datatype> &B, int i)
+			const ArrBinExpr<lhs,op,rhs,datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -328,7 +450,7 @@ struct SubOp
 	template <class datatype, int nrows, int ncols>
 	static inline auto
 	calc(const TN_Array<TN_Matrix<datatype, nrows, ncols>> &A,
-		 const TN_Array<TN_Matrix<datatype, nrows, ncols>> &B, int i)
+		 const TN_Array<TN_Matrix<datatype, nrows, ncols>> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -337,7 +459,7 @@ struct SubOp
 	template <class datatype, class lhs, class op, class rhs, int nrows, int ncols, class rtn>
 	static inline auto
 	calc(const TN_Array<TN_Matrix<datatype, nrows, ncols>> &A,
-		 const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &B, int i)
+		 const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -350,7 +472,7 @@ struct SubOp
 	static inline auto
 								calc(	const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtntype> &A,
 										const datatype &B,
-										int i)
+										TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -359,7 +481,7 @@ struct SubOp
 	template <class datatype, int nrows, int ncols, class lhs, class op, class rhs, class rtntype>
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtntype> &A,
-			const TN_Matrix<datatype, nrows, ncols> &B, int i)
+			const TN_Matrix<datatype, nrows, ncols> &B, TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -369,7 +491,7 @@ struct SubOp
 		class lhs2, class op2, class rhs2, class rtn2 >
 	static inline auto
 		calc(	const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &A,
-				const MatBinExpr<lhs1,op1,rhs1,nrows,ncols,datatype> &B, int i)
+				const MatBinExpr<lhs1,op1,rhs1,nrows,ncols,datatype> &B, TN_Index i)
 	{
 		return A.calc(i) - B;
 	}
@@ -379,7 +501,7 @@ struct SubOp
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &A,
 			const TN_Array<datatype> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -390,7 +512,7 @@ struct SubOp
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,rtn2> &A,
 			const ArrBinExpr<lhs1,op1,rhs1,datatype> &B,
-			int i)
+			TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -399,7 +521,7 @@ struct SubOp
 	template <class datatype, class lhs, class op, class rhs, int nrows, int ncols, class rtn>
 	static inline auto
 	calc(const ArrMatBinExpr<lhs,op,rhs,nrows,ncols,rtn> &A,
-		 const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B, int i)
+		 const TN_Array<TN_Matrix<datatype, nrows, ncols> > &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
@@ -409,11 +531,141 @@ struct SubOp
 	class lhs2,class op2,class rhs2,class mlhs2,class mop2,class mrhs2>
 	static inline auto
 	calc(	const ArrMatBinExpr<lhs1,op1,rhs1,nrows,ncols,MatBinExpr<mlhs1,mop1,mrhs1,nrows,ncols,datatype> > &A,
-			const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,MatBinExpr<mlhs2,mop2,mrhs2,nrows,ncols,datatype> > &B, int i)
+			const ArrMatBinExpr<lhs2,op2,rhs2,nrows,ncols,MatBinExpr<mlhs2,mop2,mrhs2,nrows,ncols,datatype> > &B, TN_Index i)
 	{
 		return A.calc(i) - B.calc(i);
 	}
 
+	//Packets
+	//*******
+
+	//calc_packet evaluates width cells at a time for arrays of doubles or floats, see TN_Simd.h
+
+	#ifndef TN_NOSIMD
+	//datatype op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const datatype &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A - B.template calc_packet<width>(i);
+	}
+
+	//datatype op ArrBinExpr
+	template <int width, class datatype, class lhs, class op, class rhs>
+	static inline auto
+	calc_packet(const datatype &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A - B.template calc_packet<width>(i);
+	}
+
+	//array op datatype
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B;
+	}
+
+	//array op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//array op ArrBinExpr
+	template <int width, class datatype, class lhs, class op, class rhs>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op datatype
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B;
+	}
+
+	//ArrBinExpr op array
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op ArrBinExpr
+	template <int width, class lhs1, class op1, class rhs1, class datatype, class lhs2, class op2, class rhs2>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs1, op1, rhs1, datatype> &A, const ArrBinExpr<lhs2, op2, rhs2, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//datatype op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const datatype &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A - B.template calc_packet<width>(i);
+	}
+
+	//view op datatype
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const datatype &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B;
+	}
+
+	//view op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//view op array
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const TN_Array<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//array op view
+	template <int width, class datatype>
+	static inline auto
+	calc_packet(const TN_Array<datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//view op ArrBinExpr
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const TN_ArrayView<datatype> &A, const ArrBinExpr<lhs, op, rhs, datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+
+	//ArrBinExpr op view
+	template <int width, class lhs, class op, class rhs, class datatype>
+	static inline auto
+	calc_packet(const ArrBinExpr<lhs, op, rhs, datatype> &A, const TN_ArrayView<datatype> &B, TN_Index i)
+	{
+		return A.template calc_packet<width>(i) - B.template calc_packet<width>(i);
+	}
+	#endif
+
 };
 
+template<>
+struct TN_HasPacket<SubOp> : std::true_type {};
+
 #endif //STRUCTSUBOP
\ No newline at end of file
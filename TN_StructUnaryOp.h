@@ -0,0 +1,238 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+#ifndef TN_STRUCTUNARYOP
+#define TN_STRUCTUNARYOP
+
+#include <cmath>
+#include <type_traits>
+
+/*
+Unary operations are held in the same expression nodes as the binary ones, with the operand
+on the left and a scalar parameter on the right, e.g. the exponent of pow(), which the
+functions without one ignore. They therefore combine with every other operator and are
+evaluated in the same single pass. Each operation supplies:
+	static inline datatype apply(const datatype &x, const datatype &p);
+	template<int width> static inline TN_Packet<datatype,width> apply_packet(const TN_Packet<datatype,width> &x, const datatype &p);
+and UnaryOp<> applies it to every cell:
+template<any templated params>
+static inline auto calc(const type1 &A, const datatype &B, TN_Index i){
+		return Fn::apply(A.calc(i), B);
+	}
+*/
+
+template <class Fn>
+struct UnaryOp
+{
+	//matrix, MatBinExpr, array, ArrBinExpr, view or tiled op parameter
+	template <class type, class datatype>
+	static inline auto calc(const type &A, const datatype &B, TN_Index i)
+	{
+		return Fn::apply(A.calc(i), B);
+	}
+
+	//arrmat op parameter, the cell's matrix expression
+	template <class datatype, int nrows, int ncols, class allocator>
+	static inline auto
+	calc(const TN_Array<TN_Matrix<datatype, nrows, ncols>, allocator> &A, const datatype &B, TN_Index i)
+	{
+		return TN_Unary<Fn>(A.calc(i), B);
+	}
+
+	//ArrMatBinExpr op parameter
+	template <class lhs, class op, class rhs, int nrows, int ncols, class rtn, class datatype>
+	static inline auto
+	calc(const ArrMatBinExpr<lhs, op, rhs, nrows, ncols, rtn> &A, const datatype &B, TN_Index i)
+	{
+		return TN_Unary<Fn>(A.calc(i), B);
+	}
+
+	//Packets
+	//*******
+
+	//calc_packet evaluates width cells at a time for arrays of doubles or floats, see TN_Simd.h
+
+	#ifndef TN_NOSIMD
+	//array or ArrBinExpr op parameter
+	template <int width, class type, class datatype>
+	static inline auto calc_packet(const type &A, const datatype &B, TN_Index i)
+	{
+		return Fn::template apply_packet<width>(A.template calc_packet<width>(i), B);
+	}
+	#endif
+};
+
+//Functions
+//*********
+
+//-x
+struct NegOp : UnaryOp<NegOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype & /*p*/){
+		return -x;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype & /*p*/){
+		return TN_Packet<datatype, width>{-x.m_v};
+	}
+	#endif
+};
+
+//|x|
+struct AbsOp : UnaryOp<AbsOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype & /*p*/){
+		if constexpr (std::is_unsigned_v<datatype>)
+			return x;
+		else
+			return x < 0 ? -x : x;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype & /*p*/){
+		return TN_Packet<datatype, width>{x.m_v < 0 ? -x.m_v : x.m_v};
+	}
+	#endif
+};
+
+//the lesser of x and p
+struct MinOp : UnaryOp<MinOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype &p){
+		return x < p ? x : p;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype &p){
+		return TN_Packet<datatype, width>{x.m_v < p ? x.m_v : p};
+	}
+	#endif
+};
+
+//the greater of x and p
+struct MaxOp : UnaryOp<MaxOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype &p){
+		return x > p ? x : p;
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype &p){
+		return TN_Packet<datatype, width>{x.m_v > p ? x.m_v : p};
+	}
+	#endif
+};
+
+/*The functions of <cmath> are applied to each cell of a packet in turn, which the compiler
+turns into vector instructions where the instruction set has them, e.g. sqrt, or with
+-ffast-math and a vector math library, exp, log and pow.*/
+struct SqrtOp : UnaryOp<SqrtOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype & /*p*/){
+		return std::sqrt(x);
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype & /*p*/){
+		TN_Packet<datatype, width> y;
+		for(int k=0; k<width; ++k)
+			y.m_v[k] = std::sqrt(x.m_v[k]);
+		return y;
+	}
+	#endif
+};
+
+struct ExpOp : UnaryOp<ExpOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype & /*p*/){
+		return std::exp(x);
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype & /*p*/){
+		TN_Packet<datatype, width> y;
+		for(int k=0; k<width; ++k)
+			y.m_v[k] = std::exp(x.m_v[k]);
+		return y;
+	}
+	#endif
+};
+
+struct LogOp : UnaryOp<LogOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype & /*p*/){
+		return std::log(x);
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype & /*p*/){
+		TN_Packet<datatype, width> y;
+		for(int k=0; k<width; ++k)
+			y.m_v[k] = std::log(x.m_v[k]);
+		return y;
+	}
+	#endif
+};
+
+//x to the power p
+struct PowOp : UnaryOp<PowOp>
+{
+	template <class datatype>
+	static inline datatype apply(const datatype &x, const datatype &p){
+		return std::pow(x, p);
+	}
+
+	#ifndef TN_NOSIMD
+	template <int width, class datatype>
+	static inline auto apply_packet(const TN_Packet<datatype, width> &x, const datatype &p){
+		TN_Packet<datatype, width> y;
+		for(int k=0; k<width; ++k)
+			y.m_v[k] = std::pow(x.m_v[k], p);
+		return y;
+	}
+	#endif
+};
+
+template<>
+struct TN_HasPacket<NegOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<AbsOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<MinOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<MaxOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<SqrtOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<ExpOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<LogOp> : std::true_type {};
+
+template<>
+struct TN_HasPacket<PowOp> : std::true_type {};
+
+#endif //TN_STRUCTUNARYOP
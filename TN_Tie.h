@@ -0,0 +1,219 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//************
+//class TN_Tie
+//************
+//assignment of several arrays from as many expressions in a single pass over their cells.
+
+#ifndef TN_TIE
+#define TN_TIE
+
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+/*tie(a, b, c) = make_tuple(e1, e2, e3) assigns the arrays a, b and c from the expressions e1,
+e2 and e3 in one parallel loop, evaluating all three at each cell before moving to the next,
+so that arrays the expressions share, e.g. the stresses read by every velocity update of a
+staggered grid, are streamed from memory once rather than once per assignment. As with
+std::tie, every expression is evaluated at a cell before any array is written there, so the
+expressions may read any of the arrays at the cell being written, e.g.
+tie(a, b) = make_tuple(b, a) swaps them, but not at other cells, e.g. through views. The arrays
+must be the same size. make_tuple copies arrays that are given to it bare, rather than in an
+expression; std::forward_as_tuple does not. Arrays of doubles or floats whose expressions can
+all be evaluated in packets, see TN_Simd.h, are assigned a packet of cells at a time.*/
+
+//the cells of an array
+template<class T>
+struct TN_ArrayCell {};
+
+template<class datatype, class allocator>
+struct TN_ArrayCell<TN_Array<datatype, allocator> >{
+	typedef datatype type;
+};
+
+#ifndef TN_NOSIMD
+
+//Packet kernels
+//**************
+
+//cells [begin,end) of every out[n] = expression n, width cells at a time, then the remainder
+template<int width, class datatype, class tuple, size_t... n>
+inline void TN_TiePackets(datatype *const *out, const tuple &expressions, TN_Index begin, TN_Index end,
+						  std::index_sequence<n...>){
+	TN_Index i = begin;
+	for(; i + width <= end; i += width){
+		auto packets = std::make_tuple(TN_PacketAt<width, datatype>(std::get<n>(expressions), i)...);
+		(std::get<n>(packets).store(out[n] + i), ...);
+	}
+	for(; i < end; ++i){
+		auto cells = std::make_tuple(datatype(TN_CellOf(std::get<n>(expressions), i))...);
+		((out[n][i] = std::get<n>(cells)), ...);
+	}
+}
+
+//one kernel per instruction set, as for single assignments
+template<class datatype, class tuple>
+__attribute__((flatten))
+void TN_TieSSE2(datatype *const *out, const tuple &expressions, TN_Index begin, TN_Index end){
+	TN_TiePackets<16/sizeof(datatype)>(out, expressions, begin, end, std::make_index_sequence<std::tuple_size_v<tuple> >());
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+template<class datatype, class tuple>
+__attribute__((target("avx2"), flatten))
+void TN_TieAVX2(datatype *const *out, const tuple &expressions, TN_Index begin, TN_Index end){
+	TN_TiePackets<32/sizeof(datatype)>(out, expressions, begin, end, std::make_index_sequence<std::tuple_size_v<tuple> >());
+};
+
+template<class datatype, class tuple>
+__attribute__((target("avx512f"), flatten))
+void TN_TieAVX512(datatype *const *out, const tuple &expressions, TN_Index begin, TN_Index end){
+	TN_TiePackets<64/sizeof(datatype)>(out, expressions, begin, end, std::make_index_sequence<std::tuple_size_v<tuple> >());
+};
+
+#endif
+
+template<class datatype, class tuple>
+using TN_TieKernel = void (*)(datatype *const *, const tuple &, TN_Index, TN_Index);
+
+template<class datatype, class tuple>
+inline TN_TieKernel<datatype, tuple> TN_TiePacketKernel(){
+	#if defined(__x86_64__) || defined(__i386__)
+		switch(TN_GetSimdLevel()){
+			case TN_SIMDAVX512:
+				return &TN_TieAVX512<datatype, tuple>;
+			case TN_SIMDAVX2:
+				return &TN_TieAVX2<datatype, tuple>;
+			default:
+				break;
+		}
+	#endif
+	return &TN_TieSSE2<datatype, tuple>;
+};
+
+#endif //TN_NOSIMD
+
+template<class... arrays>
+class TN_Tie {
+
+	private:
+
+	std::tuple<arrays &...> m_arrays;
+
+	typedef std::tuple_element_t<0, std::tuple<arrays...> > firstarray;
+	typedef typename TN_ArrayCell<firstarray>::type firstcell;
+
+	//cells [begin,end), every expression at a cell before any array is written there
+	template<class tuple, size_t... n>
+	void assigncells(const tuple &expressions, TN_Index begin, TN_Index end, std::index_sequence<n...>){
+		std::tuple<typename TN_ArrayCell<arrays>::type...> cells;
+		for(TN_Index i=begin; i < end; ++i){
+			((std::get<n>(cells) = TN_CellOf(std::get<n>(expressions), i)), ...);
+			((std::get<n>(m_arrays)(i) = std::get<n>(cells)), ...);
+		}
+	}
+
+	#ifndef TN_NOSIMD
+	//whether every array holds doubles or floats in the default layout, and every expression gives packets of them
+	template<class... exprs>
+	static constexpr bool packetcells(){
+		return TN_IsPacketType<firstcell>::value &&
+			(std::is_same_v<arrays, TN_Array<firstcell, TN_AlignedAllocator<firstcell> > > && ...) &&
+			(TN_IsPacketOperand<std::decay_t<exprs>, firstcell>::value && ...);
+	}
+
+	//as TN_Array's assignpackets, unpadded arrays in blocks and padded arrays a row at a time
+	template<class tuple>
+	void assignpackets(const tuple &expressions){
+		firstarray &first = std::get<0>(m_arrays);
+		TN_TieKernel<firstcell, tuple> kernel = TN_TiePacketKernel<firstcell, tuple>();
+		firstcell *out[sizeof...(arrays)];
+		std::apply([&](auto &... a){
+			TN_Index n = 0;
+			((out[n++] = &a(TN_Index(0))), ...);
+		}, m_arrays);
+		TN_Index nz = first.get_nz(), nzpad = first.get_nzpad(), nrows = first.get_nx()*first.get_ny();
+		if(nzpad == nz){
+			TN_Index nt = nrows*nz;
+			TN_Index nblocks = (nt + TN_PACKETBLOCK - 1)/TN_PACKETBLOCK;
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index block=0; block < nblocks; ++block){
+				kernel(out, expressions, block*TN_PACKETBLOCK, std::min(nt, (block + 1)*TN_PACKETBLOCK));
+			}
+		}
+		else{
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index row=0; row < nrows; ++row){
+				kernel(out, expressions, row*nzpad, row*nzpad + nz);
+			}
+		}
+	}
+	#endif
+
+	public:
+
+	TN_Tie(arrays &... a) : m_arrays(a...) {};
+
+	/*the arrays = the expressions, or scalars, or for arrays of matrices matrices, in order,
+	in one pass*/
+	template<class... exprs>
+	TN_Tie &operator = (const std::tuple<exprs...> &expressions){
+		static_assert(sizeof...(exprs) == sizeof...(arrays), "tie() takes one expression per array");
+		typedef std::index_sequence_for<arrays...> seq;
+		std::apply([](const auto &... a){ (a.checkwritable(), ...); }, m_arrays);
+		firstarray &first = std::get<0>(m_arrays);
+		TN_Index nx = first.get_nx(), ny = first.get_ny(), nz = first.get_nz(), nzpad = first.get_nzpad();
+
+		if constexpr ((TN_IsOutOfCore<std::decay_t<exprs> >::value || ...)){
+			//one x plane at a time, loading the tiles each expression needs serially first
+			for(TN_Index x=0; x < nx; ++x){
+				std::apply([&](const auto &... e){
+					((void)TN_CellOf(e, x*ny*nzpad), ...);
+				}, expressions);
+				#ifdef TN_PARALLELARRAY
+					#pragma omp parallel for schedule(static)
+				#endif
+				for(TN_Index row=x*ny; row < (x+1)*ny; ++row){
+					assigncells(expressions, row*nzpad, row*nzpad + nz, seq());
+				}
+			}
+			return *this;
+		}
+		#ifndef TN_NOSIMD
+		else if constexpr (packetcells<exprs...>()){
+			if(TN_GetSimdLevel() != TN_SIMDNONE){
+				assignpackets(expressions);
+				return *this;
+			}
+		}
+		#endif
+
+		#ifdef TN_PARALLELARRAY
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(TN_Index row=0; row < nx*ny; ++row){
+			assigncells(expressions, row*nzpad, row*nzpad + nz, seq());
+		}
+		return *this;
+	}
+};
+
+/*tie(a, b, ...) = make_tuple(expression, expression, ...), for arrays of any datatype and
+layout; it is more specialised than std::tie, which it therefore hides for arrays*/
+template<class... datatypes, class... allocators>
+inline TN_Tie<TN_Array<datatypes, allocators>...> tie(TN_Array<datatypes, allocators> &... arrays){
+	return TN_Tie<TN_Array<datatypes, allocators>...>(arrays...);
+}
+
+#endif //TN_TIE
@@ -0,0 +1,457 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//*******************
+//class TN_TiledArray
+//*******************
+//an out-of-core array, stored in tiles in a scratch file, of which a bounded number are kept
+//in memory in a least-recently-used cache.
+
+#ifndef TN_TILEDARRAY
+#define TN_TILEDARRAY
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <omp.h>
+#include <cerrno>
+#include <cstdlib>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+//default size of a tile; tiles are whole x planes, so a tile is at least one plane
+#ifndef TN_TILEBYTES
+	#define TN_TILEBYTES (64 << 20)
+#endif
+
+//ways of acquiring a tile from TN_TileStore::fetch
+enum TN_TileAccess{
+	TN_TILEREAD,		//read the tile
+	TN_TILEWRITE,		//read the tile, and write it back when it is evicted
+	TN_TILEOVERWRITE	//every cell will be written, so do not read the tile first
+};
+
+/*The tiles of a TN_TiledArray, the scratch file holding them, and the cache of resident
+tiles. Tiles are fetched one at a time under a lock. Once fetched, a tile's cells are read
+through m_resident without locking, so a tile is only evicted by a later fetch of another
+tile. Inside a parallel region no tile is evicted, as another thread may be reading it: a
+tile missing from the cache is loaded into an extra slot, and the cache is trimmed back to
+its size by the next fetch outside a parallel region. Assignments and reductions fetch all
+the tiles a plane needs serially before reading it in parallel, so that this is rare. When a
+tile is fetched serially, the following tiles are read ahead asynchronously.*/
+template <class datatype>
+class TN_TileStore {
+
+	struct slot{
+		std::vector<datatype, TN_AlignedAllocator<datatype> > m_data;
+		TN_Index m_tile = -1; //tile held, or -1
+		bool m_dirty = false; //must be written back before reuse
+		unsigned long m_lastuse = 0;
+		std::future<void> m_pending; //asynchronous read-ahead into this slot
+	};
+
+	int m_fd = -1; //scratch file, unlinked, so removed when closed
+	TN_Index m_ntiles, m_tilecells;
+	size_t m_tilebytes;
+	int m_nprefetch;
+	size_t m_ncache; //slots kept outside parallel regions
+	std::vector<slot> m_slots;
+	std::unique_ptr<std::atomic<datatype *>[]> m_resident; //per tile, its cells or nullptr
+	std::vector<char> m_stored; //per tile, whether it has ever been written to the file
+	std::mutex m_lock;
+	unsigned long m_clock = 0;
+	size_t m_nloads = 0, m_nstores = 0;
+
+	static void readtile(int fd, datatype *data, size_t bytes, off_t offset){
+		char *p = reinterpret_cast<char *>(data);
+		while(bytes > 0){
+			ssize_t n = ::pread(fd, p, bytes, offset);
+			if(n <= 0)
+				return; //unreadable cells are left as they were, as for uninitialised arrays
+			p += n;
+			bytes -= n;
+			offset += n;
+		}
+	};
+
+	void writetile(slot &s){
+		const char *p = reinterpret_cast<const char *>(s.m_data.data());
+		size_t bytes = m_tilebytes;
+		off_t offset = off_t(s.m_tile)*m_tilebytes;
+		while(bytes > 0){
+			ssize_t n = ::pwrite(m_fd, p, bytes, offset);
+			if(n <= 0)
+				throw std::system_error(errno, std::generic_category(), "TN_TiledArray: scratch file write");
+			p += n;
+			bytes -= n;
+			offset += n;
+		}
+		m_stored[s.m_tile] = 1;
+		s.m_dirty = false;
+		++m_nstores;
+	};
+
+	//least recently used slot, other than the one holding keep, written back and emptied
+	slot *evict(TN_Index keep){
+		slot *victim = nullptr;
+		for(slot &s : m_slots){
+			if((keep < 0 || s.m_tile != keep) && (!victim || s.m_lastuse < victim->m_lastuse))
+				victim = &s;
+		}
+		if(!victim)
+			return nullptr;
+		if(victim->m_pending.valid())
+			victim->m_pending.wait();
+		if(victim->m_tile >= 0){
+			m_resident[victim->m_tile].store(nullptr, std::memory_order_release);
+			if(victim->m_dirty)
+				writetile(*victim);
+			victim->m_tile = -1;
+		}
+		return victim;
+	};
+
+	//a slot added for a tile fetched inside a parallel region, where none can be evicted
+	slot *addslot(){
+		m_slots.emplace_back();
+		m_slots.back().m_data.resize(m_tilecells);
+		return &m_slots.back();
+	};
+
+	//the slots added inside parallel regions, least recently used first, written back and dropped
+	void trim(){
+		while(m_slots.size() > m_ncache){
+			slot *s = evict(-1);
+			m_slots.erase(m_slots.begin() + (s - m_slots.data()));
+		}
+	};
+
+	slot *find(TN_Index tile){
+		for(slot &s : m_slots){
+			if(s.m_tile == tile)
+				return &s;
+		}
+		return nullptr;
+	};
+
+	//start reading the tiles after tile in the background
+	void prefetch(TN_Index tile){
+		for(TN_Index t=tile+1; t <= tile+m_nprefetch && t < m_ntiles; ++t){
+			if(!m_stored[t] || find(t))
+				continue;
+			slot *s = evict(tile);
+			if(!s)
+				return;
+			s->m_tile = t;
+			s->m_lastuse = ++m_clock;
+			s->m_pending = std::async(std::launch::async, readtile, m_fd, s->m_data.data(),
+				m_tilebytes, off_t(t)*m_tilebytes);
+			++m_nloads;
+		}
+	};
+
+	public:
+
+	TN_TileStore(TN_Index ntiles, TN_Index tilecells, int ncache, int nprefetch, const std::string &scratchdir) :
+		m_ntiles(ntiles), m_tilecells(tilecells), m_tilebytes(size_t(tilecells)*sizeof(datatype)),
+		m_nprefetch(nprefetch), m_ncache(ncache > 0 ? ncache : 1), m_slots(m_ncache),
+		m_resident(new std::atomic<datatype *>[ntiles]), m_stored(ntiles, 0){
+		std::string name = scratchdir + "/TN_TiledArrayXXXXXX";
+		m_fd = ::mkstemp(&name[0]);
+		if(m_fd < 0)
+			throw std::system_error(errno, std::generic_category(), "TN_TiledArray: scratch file in " + scratchdir);
+		::unlink(name.c_str());
+		for(TN_Index t=0; t<ntiles; ++t)
+			m_resident[t].store(nullptr, std::memory_order_relaxed);
+		for(slot &s : m_slots)
+			s.m_data.resize(tilecells);
+	};
+
+	~TN_TileStore(){
+		for(slot &s : m_slots){
+			if(s.m_pending.valid())
+				s.m_pending.wait();
+		}
+		::close(m_fd);
+	};
+
+	TN_TileStore(const TN_TileStore &) = delete;
+	TN_TileStore &operator = (const TN_TileStore &) = delete;
+
+	//make tile resident and return its cells
+	datatype *fetch(TN_Index tile, TN_TileAccess access = TN_TILEREAD){
+		std::lock_guard<std::mutex> guard(m_lock);
+		bool parallel = omp_in_parallel();
+		if(!parallel)
+			trim();
+		slot *s = find(tile);
+		if(s){
+			if(s->m_pending.valid())
+				s->m_pending.get();
+		}
+		else{
+			s = parallel ? addslot() : evict(-1);
+			s->m_tile = tile;
+			if(access != TN_TILEOVERWRITE && m_stored[tile]){
+				readtile(m_fd, s->m_data.data(), m_tilebytes, off_t(tile)*m_tilebytes);
+				++m_nloads;
+			}
+		}
+		s->m_lastuse = ++m_clock;
+		if(access != TN_TILEREAD)
+			s->m_dirty = true;
+		m_resident[tile].store(s->m_data.data(), std::memory_order_release);
+		if(!parallel)
+			prefetch(tile);
+		return s->m_data.data();
+	};
+
+	//cells of tile if it is resident, otherwise nullptr
+	inline datatype *resident(TN_Index tile) const {
+		return m_resident[tile].load(std::memory_order_acquire);
+	};
+
+	//write every dirty tile back to the scratch file
+	void flush(){
+		std::lock_guard<std::mutex> guard(m_lock);
+		for(slot &s : m_slots){
+			if(s.m_tile >= 0 && s.m_dirty)
+				writetile(s);
+		}
+	};
+
+	inline size_t get_nloads() const {
+		return m_nloads;
+	};
+
+	inline size_t get_nstores() const {
+		return m_nstores;
+	};
+};
+
+template <class datatype>
+class TN_TiledArray;
+
+/*a cell of a TN_TiledArray, as returned by its non-const (i,j,k): reading it fetches the cell's
+tile only to read it, and assigning to it fetches the tile to be written back*/
+template <class datatype>
+class TN_TiledCell {
+
+	TN_TiledArray<datatype> &m_array;
+	TN_Index m_i;
+
+	public:
+
+	TN_TiledCell(TN_TiledArray<datatype> &array, TN_Index i) : m_array(array), m_i(i)
+	{};
+
+	inline operator datatype() const {
+		return m_array.calc(m_i);
+	};
+
+	inline TN_TiledCell &operator = (const datatype &value){
+		m_array.write(m_i) = value;
+		return *this;
+	};
+
+	inline TN_TiledCell &operator = (const TN_TiledCell &cell){
+		return *this = datatype(cell);
+	};
+
+	inline TN_TiledCell &operator += (const datatype &value){
+		m_array.write(m_i) += value;
+		return *this;
+	};
+
+	inline TN_TiledCell &operator -= (const datatype &value){
+		m_array.write(m_i) -= value;
+		return *this;
+	};
+
+	inline TN_TiledCell &operator *= (const datatype &value){
+		m_array.write(m_i) *= value;
+		return *this;
+	};
+
+	inline TN_TiledCell &operator /= (const datatype &value){
+		m_array.write(m_i) /= value;
+		return *this;
+	};
+};
+
+/*A TN_TiledArray holds an (nx,ny,nz) array in a scratch file, as tiles of tilenx whole x
+planes, and keeps at most ncache tiles in memory. Cells are laid out, and indexed by calc(i),
+exactly as in a TN_Array of the same size, so tiled arrays can be used in expressions with
+each other and with TN_Arrays. Assignment to a tiled array runs tile by tile, and within a
+tile plane by plane in parallel. Tiled arrays in the same expression must have the same size
+and tilenx.
+A TN_TiledArray is a handle: copies, including those held by expressions, share the same
+tiles. Reading a cell through (i,j,k) does not mark its tile to be written back; only
+assigning to it does.*/
+template <class datatype>
+class TN_TiledArray {
+
+	protected:
+
+	TN_Index m_nx, m_ny, m_nz; //array size
+	TN_Index m_nzpad; //padded length of the nz axis, as in TN_Array
+	TN_Index m_nynz; //used for indexing
+	TN_Index m_tilenx; //x planes per tile
+	TN_Index m_tilecells; //cells per tile, including padding
+	TN_Index m_ntiles;
+	std::shared_ptr<TN_TileStore<datatype> > m_store;
+
+	private:
+
+	inline datatype *tile(TN_Index t, TN_TileAccess access = TN_TILEREAD) const {
+		datatype *p = (access == TN_TILEREAD) ? m_store->resident(t) : nullptr;
+		return p ? p : m_store->fetch(t, access);
+	};
+
+	static std::string defaultscratchdir(){
+		const char *dir = std::getenv("TMPDIR");
+		return dir ? dir : "/tmp";
+	};
+
+	public:
+
+	/*tilenx = 0 chooses tiles of about TN_TILEBYTES. Up to nprefetch tiles following each
+	fetched tile are read ahead in the background.*/
+	TN_TiledArray(TN_Index nx, TN_Index ny, TN_Index nz, TN_Index tilenx = 0, int ncache = 4,
+			int nprefetch = 1, const std::string &scratchdir = defaultscratchdir()) :
+		m_nx(nx), m_ny(ny), m_nz(nz){
+		m_nzpad = TN_AlignedAllocator<datatype>::padded(nz);
+		m_nynz = ny*m_nzpad;
+		if(tilenx <= 0)
+			tilenx = TN_Index(TN_TILEBYTES/(m_nynz*sizeof(datatype)));
+		m_tilenx = (tilenx < 1) ? 1 : (tilenx > nx ? nx : tilenx);
+		m_tilecells = m_tilenx*m_nynz;
+		m_ntiles = (nx + m_tilenx - 1)/m_tilenx;
+		m_store = std::make_shared<TN_TileStore<datatype> >(m_ntiles, m_tilecells, ncache, nprefetch, scratchdir);
+	};
+
+	//operators
+	//*********
+
+	//Array = double or int etc
+	TN_TiledArray &operator = (const datatype &value){
+		for(TN_Index t=0; t<m_ntiles; ++t){
+			datatype *cells = tile(t, TN_TILEOVERWRITE);
+			#ifdef TN_PARALLELARRAY
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(TN_Index i=0; i<m_tilecells; ++i){
+				cells[i] = value;
+			}
+		}
+		return *this;
+	};
+
+	/*Array = expression, tile by tile. Within each tile the expression is evaluated a plane at
+	a time, first reading one cell serially so that the tiles of any tiled arrays it reads are
+	resident before the threads read them.*/
+	template<typename expr>
+	TN_TiledArray &operator = (const expr &expression){
+		for(TN_Index t=0; t<m_ntiles; ++t){
+			datatype *cells = tile(t, TN_TILEWRITE);
+			TN_Index first = t*m_tilecells;
+			for(TN_Index x=t*m_tilenx; x < (t+1)*m_tilenx && x < m_nx; ++x){
+				(void)expression.calc(x*m_nynz);
+				#ifdef TN_PARALLELARRAY
+					#pragma omp parallel for schedule(static)
+				#endif
+				for(TN_Index row=x*m_ny; row < (x+1)*m_ny; ++row){
+					for(TN_Index i=row*m_nzpad; i < row*m_nzpad + m_nz; ++i){
+						cells[i - first] = expression.calc(i);
+					}
+				}
+			}
+		}
+		return *this;
+	}
+
+	//Indexing
+	//********
+
+	//calc(i) indexing
+	inline datatype calc(TN_Index i) const {
+		TN_Index t = i/m_tilecells;
+		return tile(t)[i - t*m_tilecells];
+	};
+
+	//(i,j,k) indexing
+	inline datatype operator()(TN_Index i, TN_Index j, TN_Index k) const {
+		return calc((i*m_nynz)+(j*m_nzpad)+k);
+	};
+
+	inline TN_TiledCell<datatype> operator()(TN_Index i, TN_Index j, TN_Index k) {
+		return TN_TiledCell<datatype>(*this, (i*m_nynz)+(j*m_nzpad)+k);
+	};
+
+	//the cell at flat index i, fetching its tile to be written back
+	inline datatype &write(TN_Index i) {
+		TN_Index t = i/m_tilecells;
+		return tile(t, TN_TILEWRITE)[i - t*m_tilecells];
+	};
+
+	//write resident tiles back to the scratch file
+	void flush(){
+		m_store->flush();
+	};
+
+	inline TN_Index get_nx() const {
+		return m_nx;
+	};
+
+	inline TN_Index get_ny() const {
+		return m_ny;
+	};
+
+	inline TN_Index get_nz() const {
+		return m_nz;
+	};
+
+	inline TN_Index get_nt() const {
+		return m_nx*m_ny*m_nz;
+	};
+
+	inline TN_Index get_nzpad() const {
+		return m_nzpad;
+	};
+
+	inline TN_Index get_tilenx() const {
+		return m_tilenx;
+	};
+
+	inline TN_Index get_ntiles() const {
+		return m_ntiles;
+	};
+
+	//tiles read from, and written to, the scratch file so far
+	inline size_t get_nloads() const {
+		return m_store->get_nloads();
+	};
+
+	inline size_t get_nstores() const {
+		return m_store->get_nstores();
+	};
+};
+
+template<class datatype>
+struct TN_IsOutOfCore<TN_TiledArray<datatype> > : std::true_type {};
+
+template<class datatype>
+struct TN_HasExtent<TN_TiledArray<datatype> > : std::true_type {};
+
+#endif //unix
+
+#endif //TN_TILEDARRAY
@@ -0,0 +1,1029 @@
+/**************************
+TUNGSTEN Arrays of matrices
+ Copyright Ben McLean 2023
+** drbenmclean@gmail.com **
+**************************/
+
+//to run benchmarks, do "make bench"
+//the grid edge length can be given on the command line, e.g. "./benchmark 64"
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <cstdint>
+#include <cstdio>
+
+#define TN_PARALLELARRAY
+
+#include "TN_Numerics.h"
+
+//Allocation counting
+//*******************
+
+//global operator new is replaced so that each benchmark can report how many heap
+//allocations, and how many bytes, it made. GCC cannot see that the replaced operator
+//delete matches the replaced operator new, so its mismatch warning is disabled.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static size_t tn_nallocs = 0;
+static size_t tn_nbytes = 0;
+
+void *operator new(size_t size){
+	#pragma omp atomic
+	++tn_nallocs;
+	#pragma omp atomic
+	tn_nbytes += size;
+	if(void *p = malloc(size ? size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void *operator new(size_t size, align_val_t align){
+	#pragma omp atomic
+	++tn_nallocs;
+	#pragma omp atomic
+	tn_nbytes += size;
+	size_t a = static_cast<size_t>(align);
+	if(void *p = aligned_alloc(a, ((size + a - 1)/a)*a))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { free(p); }
+
+static void resetcounts(){
+	tn_nallocs = 0;
+	tn_nbytes = 0;
+}
+
+//Timing
+//******
+
+//best wall-clock time in seconds of reps calls to f
+template<class func>
+double besttime(func f, int reps = 5){
+	double best = 1e300;
+	for(int r=0; r<reps; ++r){
+		auto start = chrono::steady_clock::now();
+		f();
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+		if(elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	int n = (argc > 1) ? atoi(argv[1]) : 48;
+	long int ncells = long(n)*n*n;
+
+	cout << endl << "TN_Numerics benchmarks on a " << n << "^3 grid..." << endl;
+
+	//***********************
+	//  Matrix storage
+	//***********************
+
+	/*Arrays of 6x6 matrices, as used for elastic stiffness tensors. Reports the bytes per
+	cell, the allocations made when the array is constructed, and the effective bandwidth of a
+	cell-wise add. Compile with -DTN_HEAPMATRIX to compare against heap-allocated matrices.*/
+	{
+		typedef TN_Matrix<double,6,6> mat66;
+		#ifdef TN_HEAPMATRIX
+			cout << endl << "Matrix storage: heap (TN_HEAPMATRIX)" << endl;
+			size_t cellbytes = sizeof(mat66) + sizeof(double)*36;
+		#else
+			cout << endl << "Matrix storage: inline" << endl;
+			size_t cellbytes = sizeof(mat66);
+		#endif
+		cout << "  bytes per 6x6 cell     : " << cellbytes << " (payload " << sizeof(double)*36 << ")" << endl;
+
+		resetcounts();
+		double tconstruct = besttime([&](){
+			TN_Array<mat66> am(n,n,n);
+		}, 1);
+		cout << "  construction           : " << tconstruct*1e3 << " ms, "
+			 << tn_nallocs << " allocations, " << tn_nbytes/1048576.0 << " MB" << endl;
+
+		TN_Array<mat66> am1(n,n,n), am2(n,n,n), am3(n,n,n);
+		am1.setrandom();
+		am2.setrandom();
+		double tadd = besttime([&](){
+			am3 = am1 + am2;
+		});
+		double bytes = 3.0*ncells*sizeof(double)*36;
+		cout << "  am3 = am1 + am2        : " << tadd*1e3 << " ms, " << bytes/tadd/1e9 << " GB/s" << endl;
+	}
+
+	//***********************
+	//  Array-of-matrices layout
+	//***********************
+
+	/*Per-cell stiffness times strain, as in an elastic stress update. Compile with
+	-DTN_SOAARRAYSOFMATRICES to compare the plane-by-plane (SoA) layout against whole
+	matrices per cell.*/
+	{
+		#ifdef TN_SOAARRAYSOFMATRICES
+			cout << endl << "Array-of-matrices layout: SoA (TN_SOAARRAYSOFMATRICES)" << endl;
+		#else
+			cout << endl << "Array-of-matrices layout: matrix per cell" << endl;
+		#endif
+		TN_Array<TN_Matrix<double,6,6> > stiffness(n,n,n);
+		TN_Array<TN_Matrix<double,6,1> > strain(n,n,n), stress(n,n,n);
+		stiffness.setrandom();
+		strain.setrandom();
+		double tmul = besttime([&](){
+			stress = stiffness * strain;
+		});
+		double bytes = double(ncells)*sizeof(double)*(36 + 6 + 6);
+		cout << "  stress = C * strain    : " << tmul*1e3 << " ms, " << bytes/tmul/1e9 << " GB/s" << endl;
+		double tscale = besttime([&](){
+			stress = (strain * 2.0) + stress;
+		});
+		bytes = double(ncells)*sizeof(double)*(6 + 6 + 6);
+		cout << "  stress = 2*strain + s  : " << tscale*1e3 << " ms, " << bytes/tscale/1e9 << " GB/s" << endl;
+	}
+
+	//***********************
+	//  Index type
+	//***********************
+
+	/*Scalar array expressions with the default 64-bit TN_Index. Compile with -DTN_INDEX32
+	to compare against 32-bit loops.*/
+	{
+		cout << endl << "Index type: " << 8*sizeof(TN_Index) << "-bit" << endl;
+		TN_Array<double> a(n,n,n), b(n,n,n), c(n,n,n);
+		a.setrandom(1,9);
+		b.setrandom(1,9);
+		double tadd = besttime([&](){
+			c = a + b;
+		});
+		double bytes = 3.0*ncells*sizeof(double);
+		cout << "  c = a + b              : " << tadd*1e3 << " ms, " << bytes/tadd/1e9 << " GB/s" << endl;
+		double texpr = besttime([&](){
+			c = (a * 3.76) * (b + 4.13) / a;
+		});
+		cout << "  c = (a*s)*(b+s)/a      : " << texpr*1e3 << " ms, " << bytes/texpr/1e9 << " GB/s" << endl;
+	}
+
+	//***********************
+	//  Allocation policy
+	//***********************
+
+	/*An nz extent that is not a multiple of the SIMD width, so that unpadded rows start at
+	varying alignments. Compile with -DTN_PADCELLS=8 to pad each row to 8 cells.*/
+	{
+		TN_Index nz = n + 3;
+		TN_Array<double> a(n,n,nz), b(n,n,nz), c(n,n,nz);
+		cout << endl << "Allocation policy: nz " << nz << " padded to " << c.get_nzpad()
+			 << ", data 64-byte aligned: " << (reinterpret_cast<uintptr_t>(c.data()) % 64 == 0 ? "yes" : "no") << endl;
+		a.setrandom(1,9);
+		b.setrandom(1,9);
+		double tadd = besttime([&](){
+			c = a + b;
+		});
+		double bytes = 3.0*n*n*nz*sizeof(double);
+		cout << "  c = a + b              : " << tadd*1e3 << " ms, " << bytes/tadd/1e9 << " GB/s" << endl;
+		double texpr = besttime([&](){
+			c = (a * 3.76) * (b + 4.13) / a;
+		});
+		cout << "  c = (a*s)*(b+s)/a      : " << texpr*1e3 << " ms, " << bytes/texpr/1e9 << " GB/s" << endl;
+	}
+
+	//***********************
+	//  NUMA first touch
+	//***********************
+
+	/*STREAM-style triad on arrays 16x larger than the grid. Pages of arrays first touched
+	serially by the master thread all sit on one socket, while arrays first touched by the
+	parallel loops are spread over the sockets of the threads that use them. Compile with
+	-DTN_INTERLEAVE to interleave pages across NUMA nodes instead.*/
+	{
+		cout << endl << "NUMA first touch, " << omp_get_max_threads() << " threads"
+		#ifdef TN_INTERLEAVE
+			 << ", pages interleaved (TN_INTERLEAVE)"
+		#endif
+			 << endl;
+		TN_Index nx = 4*n, ny = 4*n, nz = n;
+		double bytes = 3.0*nx*ny*nz*sizeof(double);
+
+		//before: every page first touched by the master thread
+		{
+			TN_Array<double> a(nx,ny,nz), b(nx,ny,nz), c(nx,ny,nz);
+			for(TN_Index i=0; i<a.get_ntpad(); ++i){
+				a.data()[i] = 0.0;
+				b.data()[i] = 1.0;
+				c.data()[i] = 2.0;
+			}
+			double ttriad = besttime([&](){
+				a = b + (c * 3.0);
+			});
+			cout << "  serial first touch     : " << ttriad*1e3 << " ms, " << bytes/ttriad/1e9 << " GB/s" << endl;
+		}
+
+		//after: pages first touched by the parallel assignment loops
+		{
+			double tconstruct = besttime([&](){
+				TN_Array<double> a(nx,ny,nz);
+			}, 1);
+			TN_Array<double> a(nx,ny,nz), b(nx,ny,nz), c(nx,ny,nz);
+			b = 1.0;
+			c = 2.0;
+			double tfirst = besttime([&](){
+				a = b + (c * 3.0);
+			}, 1);
+			double ttriad = besttime([&](){
+				a = b + (c * 3.0);
+			});
+			cout << "  construction           : " << tconstruct*1e3 << " ms" << endl;
+			cout << "  first assignment       : " << tfirst*1e3 << " ms" << endl;
+			cout << "  parallel first touch   : " << ttriad*1e3 << " ms, " << bytes/ttriad/1e9 << " GB/s" << endl;
+		}
+	}
+
+	//***********************
+	//  Copies and moves
+	//***********************
+
+	/*Filling, copying and swapping scalar arrays. Swapping time-step buffers and returning
+	arrays from functions should not touch the data at all.*/
+	{
+		cout << endl << "Copies and moves" << endl;
+		TN_Array<double> a(n,n,n), b(n,n,n);
+		a = 1.0;
+		b = 2.0;
+		double tfill = besttime([&](){
+			a = 0.0;
+		});
+		cout << "  a = 0.0                : " << tfill*1e3 << " ms" << endl;
+		volatile double sink = 0.0;
+		double tcopy = besttime([&](){
+			TN_Array<double> c(a);
+			sink = sink + c(ncells-1);
+		});
+		cout << "  copy construct         : " << tcopy*1e3 << " ms" << endl;
+		resetcounts();
+		double tswap = besttime([&](){
+			swap(a, b);
+		});
+		cout << "  swap(a,b)              : " << tswap*1e3 << " ms, " << tn_nallocs << " allocations" << endl;
+		resetcounts();
+		double tmove = besttime([&](){
+			TN_Array<double> c(std::move(a));
+			a = std::move(c);
+		});
+		cout << "  move out and back      : " << tmove*1e3 << " ms, " << tn_nallocs << " allocations" << endl;
+	}
+
+	//***********************
+	//  Views
+	//***********************
+
+	/*Updating one boundary plane of an array, through a view, against copying the whole
+	volume to do the same.*/
+	{
+		cout << endl << "Views" << endl;
+		TN_Array<double> a(n,n,n), b(n,n,n);
+		a.setrandom(1,9);
+		b.setrandom(1,9);
+		double tfull = besttime([&](){
+			b = a * 0.5;
+		});
+		cout << "  b = a*0.5, full volume : " << tfull*1e3 << " ms" << endl;
+		double tslab = besttime([&](){
+			b.slicex(0) = a.slicex(1) * 0.5;
+		});
+		cout << "  b.slicex(0) = ...      : " << tslab*1e3 << " ms" << endl;
+		double tstride = besttime([&](){
+			b.view(TN_Range(0,n,2), TN_Range(0,n,2), TN_Range(0,n,2)) = 0.0;
+		});
+		cout << "  every other cell = 0.0 : " << tstride*1e3 << " ms" << endl;
+	}
+
+	//***********************
+	//  File-backed arrays
+	//***********************
+
+	/*Starting from a model on disk: reading the file into an array, against mapping it with
+	TN_MappedArray, then summing the model once. The file is written first, so both start
+	from the page cache.*/
+	{
+		#if defined(__unix__) || defined(__APPLE__)
+			cout << endl << "File-backed arrays" << endl;
+			TN_Index nx = 4*n, ny = 4*n, nz = n;
+			const char *filename = "benchmark_model.bin";
+			{
+				TN_Array<double> model(nx,ny,nz);
+				model.setrandom(1,9);
+				FILE *f = fopen(filename, "wb");
+				for(TN_Index row=0; row < nx*ny; ++row)
+					fwrite(model.data() + row*model.get_nzpad(), sizeof(double), nz, f);
+				fclose(f);
+			}
+			TN_Array<double> sum(nx,ny,nz);
+			double tread = besttime([&](){
+				TN_Array<double> model(nx,ny,nz);
+				FILE *f = fopen(filename, "rb");
+				for(TN_Index row=0; row < nx*ny; ++row)
+					if(fread(model.data() + row*model.get_nzpad(), sizeof(double), nz, f) != size_t(nz))
+						break;
+				fclose(f);
+			}, 3);
+			cout << "  read into TN_Array     : " << tread*1e3 << " ms" << endl;
+			if(nz == TN_Array<double>(1,1,nz).get_nzpad()){
+				double tmap = besttime([&](){
+					TN_MappedArray<double> model(filename, nx, ny, nz);
+				}, 3);
+				cout << "  map as TN_MappedArray  : " << tmap*1e3 << " ms" << endl;
+				TN_MappedArray<double> model(filename, nx, ny, nz, TN_MAPREADONLY, TN_ADVISESEQUENTIAL);
+				double tuse = besttime([&](){
+					sum = model + 1.0;
+				});
+				cout << "  sum = mapped + 1.0     : " << tuse*1e3 << " ms" << endl;
+				//comparisons and where() take a mapped array as any other array
+				TN_Array<double> clipped(nx,ny,nz), expected(nx,ny,nz);
+				clipped = where(model > 5.0, 5.0, model);
+				expected = model;
+				expected = where(expected > 5.0, 5.0, expected);
+				bool clips = max(abs(clipped - expected)) == 0.0 && max(clipped) == 5.0;
+				cout << "  where(mapped > 5.0)    : " << (clips ? "matches" : "DIFFERS") << endl;
+				if(!clips){
+					remove(filename);
+					return 1;
+				}
+			}
+			remove(filename);
+		#endif
+	}
+
+	//***********************
+	//  Out-of-core arrays
+	//***********************
+
+	/*A triad on tiled arrays, each holding 16 tiles on disk and at most 4 in memory, against
+	the same triad in memory. Reports the tiles read and written per triad.*/
+	{
+		#if defined(__unix__) || defined(__APPLE__)
+			cout << endl << "Out-of-core arrays" << endl;
+			TN_Index nx = 4*n, ny = 4*n, nz = n;
+			double bytes = 3.0*nx*ny*nz*sizeof(double);
+			{
+				TN_Array<double> a(nx,ny,nz), b(nx,ny,nz), c(nx,ny,nz);
+				b = 1.0;
+				c = 2.0;
+				double ttriad = besttime([&](){
+					a = b + (c * 3.0);
+				});
+				cout << "  in memory              : " << ttriad*1e3 << " ms, " << bytes/ttriad/1e9 << " GB/s" << endl;
+			}
+			{
+				TN_TiledArray<double> a(nx,ny,nz,nx/16,4), b(nx,ny,nz,nx/16,4), c(nx,ny,nz,nx/16,4);
+				b = 1.0;
+				c = 2.0;
+				a = b + (c * 3.0);
+				size_t nloads = a.get_nloads() + b.get_nloads() + c.get_nloads();
+				size_t nstores = a.get_nstores() + b.get_nstores() + c.get_nstores();
+				double ttriad = besttime([&](){
+					a = b + (c * 3.0);
+				}, 3);
+				cout << "  tiled, 4 of 16 tiles   : " << ttriad*1e3 << " ms, " << bytes/ttriad/1e9 << " GB/s, "
+					 << (a.get_nloads() + b.get_nloads() + c.get_nloads() - nloads)/3 << " tile loads, "
+					 << (a.get_nstores() + b.get_nstores() + c.get_nstores() - nstores)/3 << " tile stores" << endl;
+			}
+		#endif
+	}
+
+	//***********************
+	//  Temporaries
+	//***********************
+
+	/*Per-cell inverse of 4x4 matrices, serially, as in a material update. Reports the heap
+	allocations made per cell without and with a TN_ArenaScope around each cell. Matrices are
+	stored inline, so only -DTN_HEAPMATRIX makes heap allocations to begin with.*/
+	{
+		cout << endl << "Temporaries" << endl;
+		typedef TN_Matrix<double,4,4> mat44;
+		TN_Index ninv = n*n*4;
+		mat44 A, inv;
+		A.set(	4, 1, 0, 0,
+				1, 4, 1, 0,
+				0, 1, 4, 1,
+				0, 0, 1, 4);
+		volatile double sink = 0.0;
+		resetcounts();
+		double tplain = besttime([&](){
+			for(TN_Index c=0; c<ninv; ++c){
+				inv = inverse(A);
+				sink = sink + inv(0,0);
+			}
+		}, 1);
+		cout << "  inverse per cell       : " << tplain/ninv*1e9 << " ns, "
+			 << double(tn_nallocs)/ninv << " allocations per cell" << endl;
+		{
+			TN_ArenaScope warmup;
+			inv = inverse(A);
+		}
+		resetcounts();
+		double tarena = besttime([&](){
+			for(TN_Index c=0; c<ninv; ++c){
+				TN_ArenaScope scope;
+				inv = inverse(A);
+				sink = sink + inv(0,0);
+			}
+		}, 1);
+		cout << "  with TN_ArenaScope     : " << tarena/ninv*1e9 << " ns, "
+			 << double(tn_nallocs)/ninv << " allocations per cell, "
+			 << TN_Arena::local().get_capacity()/1024 << " kB arena" << endl;
+
+		//results declared outside a scope must keep their cells once a later scope reuses the arena
+		mat44 reference = inverse(A), kept;
+		TN_Array<double> keptarray(n,n,n);
+		{
+			TN_ArenaScope scope;
+			kept = inverse(A);
+			TN_Array<double> temporary(n,n,n);
+			temporary = 1.0;
+			keptarray = std::move(temporary);
+		}
+		{
+			TN_ArenaScope scope;
+			mat44 other;
+			other = 12345.0;
+			TN_Array<double> otherarray(n,n,n);
+			otherarray = 12345.0;
+		}
+		bool intact = (kept == reference) && keptarray(n-1,n-1,n-1) == 1.0 && keptarray(0,0,0) == 1.0;
+		cout << "  results outside scopes : " << (intact ? "intact" : "OVERWRITTEN") << endl;
+		if(!intact)
+			return 1;
+	}
+
+	//***********************
+	//  Expression nodes
+	//***********************
+
+	/*Scalar arrays, small matrices and arrays of matrices used together in one build. Arrays and
+	matrices are held in expressions by reference, so building and evaluating an expression
+	should neither copy its operands nor allocate.*/
+	{
+		cout << endl << "Expression nodes" << endl;
+		TN_Array<double> a(n,n,n), b(n,n,n), c(n,n,n);
+		a.setrandom(1.0, 9.0);
+		b.setrandom(1.0, 9.0);
+		resetcounts();
+		double tarr = besttime([&](){ c = (a * 3.76) * (b + 4.13) / a; });
+		cout << "  scalar array expression: " << tarr*1e3 << " ms, "
+			 << tn_nallocs/5.0 << " allocations per evaluation" << endl;
+
+		TN_Matrix<double,6,10> m1, m2;
+		TN_Matrix<double,10,4> m4, m5;
+		TN_Matrix<double,6,4> m6;
+		m1.setrandom();
+		m2.setrandom();
+		m4.setrandom();
+		m5.setrandom();
+		int nmat = 100000;
+		volatile double sink = 0.0;
+		resetcounts();
+		double tmat = besttime([&](){
+			for(int r=0; r<nmat; ++r){
+				m6 = ((m1 + 7.9) * m4) - ((m2 * 2.8) * (3.3 + m5));
+				sink = sink + m6(0,0);
+			}
+		});
+		cout << "  matrix expression      : " << tmat/nmat*1e9 << " ns, "
+			 << double(tn_nallocs)/(5*nmat) << " allocations per evaluation" << endl;
+
+		TN_Array<TN_Matrix<double,6,6> > C(n/2,n,n);
+		TN_Array<TN_Matrix<double,6,1> > e(n/2,n,n), s(n/2,n,n);
+		C.setrandom();
+		e.setrandom();
+		resetcounts();
+		double tam = besttime([&](){ s = C * e + e * 2.0; });
+		cout << "  array-of-matrices expr : " << tam*1e3 << " ms, "
+			 << tn_nallocs/5.0 << " allocations per evaluation" << endl;
+	}
+
+	//***********************
+	//  SIMD packets
+	//***********************
+
+	/*Scalar array expressions evaluated cell by cell and then in packets of each width the
+	processor supports, from SSE2 up. The division-heavy expression is the one compilers are
+	least likely to vectorise by themselves.*/
+	{
+		cout << endl << "SIMD packets" << endl;
+		TN_Array<double> a(n,n,n), b(n,n,n), c(n,n,n);
+		a.setrandom(1,9);
+		b.setrandom(1,9);
+		double bytes = 3.0*ncells*sizeof(double);
+		const char *names[] = {"cell by cell", "SSE2", "AVX2", "AVX-512"};
+		for(int level = TN_SIMDNONE; level <= TN_SimdSupported(); ++level){
+			TN_SetSimdLevel(TN_SimdLevel(level));
+			double tadd = besttime([&](){
+				c = a + b;
+			});
+			double texpr = besttime([&](){
+				c = (a * 3.76) * (b + 4.13) / a;
+			});
+			double tdiv = besttime([&](){
+				c = 2.0/(a - b*0.5) + a/b;
+			});
+			cout << "  " << names[level] << ":" << endl;
+			cout << "    c = a + b            : " << tadd*1e3 << " ms, " << bytes/tadd/1e9 << " GB/s" << endl;
+			cout << "    c = (a*s)*(b+s)/a    : " << texpr*1e3 << " ms" << endl;
+			cout << "    c = s/(a-b*s) + a/b  : " << tdiv*1e3 << " ms" << endl;
+		}
+		TN_SetSimdLevel(TN_SIMDAVX512);
+	}
+
+	//***********************
+	//  Compound assignment
+	//***********************
+
+	/*Time-step updates written out in full and with compound assignment, for scalar arrays
+	and for arrays of matrices, including a per-cell product with 6x6 matrices.*/
+	{
+		cout << endl << "Compound assignment" << endl;
+		TN_Array<double> v(n,n,n), a(n,n,n), b(n,n,n);
+		v.setrandom(1,9);
+		a.setrandom(1,9);
+		b.setrandom(1,9);
+		double dt = 1e-3;
+		double tfull = besttime([&](){
+			v = v + dt*(a - b);
+		});
+		double tcompound = besttime([&](){
+			v += dt*(a - b);
+		});
+		cout << "  v = v + dt*(a-b)       : " << tfull*1e3 << " ms" << endl;
+		cout << "  v += dt*(a-b)          : " << tcompound*1e3 << " ms" << endl;
+
+		TN_Array<TN_Matrix<double,6,1> > stress(n/2,n,n), rate(n/2,n,n);
+		TN_Array<TN_Matrix<double,6,6> > rotation(n/2,n,n);
+		stress.setrandom();
+		rate.setrandom();
+		rotation.setrandom();
+		tfull = besttime([&](){
+			stress = stress + rate*dt;
+		});
+		tcompound = besttime([&](){
+			stress += rate*dt;
+		});
+		cout << "  s = s + r*dt (6x1)     : " << tfull*1e3 << " ms" << endl;
+		cout << "  s += r*dt (6x1)        : " << tcompound*1e3 << " ms" << endl;
+		TN_Array<TN_Matrix<double,1,6> > strain(n/2,n,n);
+		strain.setrandom();
+		tcompound = besttime([&](){
+			strain *= rotation;
+		});
+		cout << "  e *= R (1x6 * 6x6)     : " << tcompound*1e3 << " ms" << endl;
+	}
+
+	//***********************
+	//  Aliasing
+	//***********************
+
+	/*Products assigned to one of their own operands go through a temporary, found by comparing
+	addresses at run time; products into another matrix, and elementwise expressions, do not.*/
+	{
+		cout << endl << "Aliasing" << endl;
+		TN_Matrix<double,6,6> m0, m, r, b;
+		m0.setrandom();
+		b.setrandom();
+		int nmat = 100000;
+		volatile double sink = 0.0;
+		double tplain = besttime([&](){
+			for(int i=0; i<nmat; ++i){
+				m = m0;
+				r = m * b;
+				sink = sink + r(0,0);
+			}
+		});
+		double talias = besttime([&](){
+			for(int i=0; i<nmat; ++i){
+				m = m0;
+				m = m * b;
+				sink = sink + m(0,0);
+			}
+		});
+		double telement = besttime([&](){
+			for(int i=0; i<nmat; ++i){
+				m = m0;
+				m = m + b*0.5;
+				sink = sink + m(0,0);
+			}
+		});
+		cout << "  r = m*b (6x6)          : " << tplain/nmat*1e9 << " ns" << endl;
+		cout << "  m = m*b (6x6)          : " << talias/nmat*1e9 << " ns" << endl;
+		cout << "  m = m + b*0.5 (6x6)    : " << telement/nmat*1e9 << " ns" << endl;
+
+		TN_Array<TN_Matrix<double,6,6> > a0(n/2,n,n), a(n/2,n,n), c(n/2,n,n), C(n/2,n,n);
+		a0.setrandom();
+		C.setrandom();
+		a = a0;
+		tplain = besttime([&](){
+			c = a * C;
+		});
+		talias = besttime([&](){
+			a = a0;
+			a = a * C;
+		});
+		double tcopy = besttime([&](){
+			a = a0;
+		});
+		cout << "  c = a*C (6x6 cells)    : " << tplain*1e3 << " ms" << endl;
+		cout << "  a = a*C (6x6 cells)    : " << (talias - tcopy)*1e3 << " ms" << endl;
+	}
+
+	//***********************
+	//  Nested products
+	//***********************
+
+	/*Nested products, which are materialised within TN_SCRATCHBYTES, against the same
+	products with the temporary written out; build with -DTN_SCRATCHBYTES=0 to compare
+	against evaluating them straight through.*/
+	{
+		cout << endl << "Nested products (TN_SCRATCHBYTES " << TN_SCRATCHBYTES << ")" << endl;
+		TN_Matrix<double,12,12> A, B, C, D, T;
+		B.setrandom();
+		C.setrandom();
+		D.setrandom();
+		int nmat = 10000;
+		volatile double sink = 0.0;
+		double tnested = besttime([&](){
+			for(int i=0; i<nmat; ++i){
+				A = B * (C * D);
+				sink = sink + A(0,0);
+			}
+		});
+		double ttemp = besttime([&](){
+			for(int i=0; i<nmat; ++i){
+				T = C * D;
+				A = B * T;
+				sink = sink + A(0,0);
+			}
+		});
+		cout << "  A = B*(C*D) (12x12)    : " << tnested/nmat*1e9 << " ns" << endl;
+		cout << "  T = C*D; A = B*T       : " << ttemp/nmat*1e9 << " ns" << endl;
+
+		TN_Array<TN_Matrix<double,6,6> > a(n/2,n,n), b(n/2,n,n), c(n/2,n,n), d(n/2,n,n), t(n/2,n,n);
+		b.setrandom();
+		c.setrandom();
+		d.setrandom();
+		tnested = besttime([&](){
+			a = b * (c * d);
+		});
+		ttemp = besttime([&](){
+			t = c * d;
+			a = b * t;
+		});
+		cout << "  a = b*(c*d) (6x6 cells): " << tnested*1e3 << " ms" << endl;
+		cout << "  t = c*d; a = b*t       : " << ttemp*1e3 << " ms" << endl;
+	}
+
+	//***********************
+	//  Unary functions
+	//***********************
+
+	/*P and S velocities from the bulk and shear moduli and the density, in one fused pass
+	per velocity, against a hand-written loop.*/
+	{
+		cout << endl << "Unary functions" << endl;
+		TN_Array<double> K(n,n,n), G(n,n,n), rho(n,n,n), vp(n,n,n), vs(n,n,n);
+		K.setrandom(10,50);
+		G.setrandom(5,30);
+		rho.setrandom(2,3);
+		double tfused = besttime([&](){
+			vp = sqrt((K + G*(4.0/3.0))/rho);
+			vs = sqrt(G/rho);
+		});
+		TN_Index ntot = TN_Index(n)*n*n;
+		double *pvp = &vp(0,0,0), *pvs = &vs(0,0,0);
+		const double *pK = &K(0,0,0), *pG = &G(0,0,0), *prho = &rho(0,0,0);
+		double tloop = besttime([&](){
+			for(TN_Index i=0; i<ntot; ++i){
+				pvp[i] = std::sqrt((pK[i] + pG[i]*(4.0/3.0))/prho[i]);
+				pvs[i] = std::sqrt(pG[i]/prho[i]);
+			}
+		});
+		cout << "  vp, vs expressions     : " << tfused*1e3 << " ms" << endl;
+		cout << "  vp, vs hand-written    : " << tloop*1e3 << " ms" << endl;
+		double tclamp = besttime([&](){
+			vp = max(-K, -30.0) + abs(G - K);
+		});
+		cout << "  max(-K,s) + abs(G-K)   : " << tclamp*1e3 << " ms" << endl;
+	}
+
+	//***********************
+	//  Reductions
+	//***********************
+
+	/*The CFL time step from the largest P velocity, the elastic energy norm of a stress
+	field, and a sum, against hand-written loops.*/
+	{
+		cout << endl << "Reductions" << endl;
+		TN_Array<double> K(n,n,n), G(n,n,n), rho(n,n,n), sxx(n,n,n);
+		K.setrandom(10,50);
+		G.setrandom(5,30);
+		rho.setrandom(2,3);
+		sxx.setrandom(-1,1);
+		double dt = 0, energy = 0, total = 0;
+		double tcfl = besttime([&](){
+			dt = 0.5*10.0/max(sqrt((K + G*(4.0/3.0))/rho));
+		});
+		double tenergy = besttime([&](){
+			energy = norm(sxx/sqrt(K));
+		});
+		double tsum = besttime([&](){
+			total = sum(sxx);
+		});
+		TN_Index ntot = TN_Index(n)*n*n;
+		const double *psxx = &sxx(0,0,0);
+		double hand = 0;
+		double tloop = besttime([&](){
+			hand = 0;
+			for(TN_Index i=0; i<ntot; ++i)
+				hand += psxx[i];
+		});
+		cout << "  CFL dt from max(vp)    : " << tcfl*1e3 << " ms (dt " << dt << ")" << endl;
+		cout << "  energy norm            : " << tenergy*1e3 << " ms (" << energy << ")" << endl;
+		cout << "  sum                    : " << tsum*1e3 << " ms (" << total << ")" << endl;
+		cout << "  sum hand-written       : " << tloop*1e3 << " ms (" << hand << ")" << endl;
+	}
+
+	//***********************
+	//  Masks and where
+	//***********************
+
+	/*Clipping velocities and zeroing a water layer with where(), against hand-written loops
+	that branch on each cell.*/
+	{
+		cout << endl << "Masks and where" << endl;
+		TN_Array<double> vp(n,n,n), depth(n,n,n), u(n,n,n), r(n,n,n);
+		vp.setrandom(1000,6000);
+		depth.setrandom(-9,9);
+		u.setrandom(-1,1);
+		double vmax = 4500.0;
+		double twhere = besttime([&](){
+			r = where(vp > vmax, vmax, vp) + where(depth < 0.0, 0.0, u);
+		});
+		TN_Index ntot = TN_Index(n)*n*n;
+		double *pr = &r(0,0,0);
+		const double *pvp = &vp(0,0,0), *pdepth = &depth(0,0,0), *pu = &u(0,0,0);
+		double tloop = besttime([&](){
+			for(TN_Index i=0; i<ntot; ++i){
+				double v = pvp[i];
+				if(v > vmax)
+					v = vmax;
+				if(pdepth[i] >= 0.0)
+					v += pu[i];
+				pr[i] = v;
+			}
+		});
+		cout << "  where expressions      : " << twhere*1e3 << " ms" << endl;
+		cout << "  hand-written branches  : " << tloop*1e3 << " ms" << endl;
+		double count = 0;
+		double tcount = besttime([&](){
+			count = sum(vp > vmax);
+		});
+		cout << "  sum(vp > vmax)         : " << tcount*1e3 << " ms (" << count << " cells)" << endl;
+	}
+
+	//***********************
+	//  Tied assignment
+	//***********************
+
+	/*A velocity update on a staggered grid, whose three components read the same density and
+	stresses, as three assignments and as one tied assignment.*/
+	{
+		cout << endl << "Tied assignment" << endl;
+		TN_Array<double> vx(n,n,n), vy(n,n,n), vz(n,n,n), rho(n,n,n);
+		TN_Array<double> sxx(n,n,n), syy(n,n,n), szz(n,n,n), sxy(n,n,n), sxz(n,n,n), syz(n,n,n);
+		vx = 0.0; vy = 0.0; vz = 0.0;
+		rho.setrandom(2,3);
+		sxx.setrandom(-1,1); syy.setrandom(-1,1); szz.setrandom(-1,1);
+		sxy.setrandom(-1,1); sxz.setrandom(-1,1); syz.setrandom(-1,1);
+		double dt = 1e-3;
+		double tseparate = besttime([&](){
+			vx = vx + dt*(sxx + sxy + sxz)/rho;
+			vy = vy + dt*(sxy + syy + syz)/rho;
+			vz = vz + dt*(sxz + syz + szz)/rho;
+		});
+		double ttied = besttime([&](){
+			tie(vx, vy, vz) = make_tuple(	vx + dt*(sxx + sxy + sxz)/rho,
+											vy + dt*(sxy + syy + syz)/rho,
+											vz + dt*(sxz + syz + szz)/rho);
+		});
+		cout << "  three assignments      : " << tseparate*1e3 << " ms" << endl;
+		cout << "  tie(vx,vy,vz) =        : " << ttied*1e3 << " ms" << endl;
+	}
+
+	//***********************
+	//  Broadcasting
+	//***********************
+
+	/*A depth profile and a surface map added to a full array, expanded into full arrays first and
+	as broadcast views of their own (1,1,n) and (n,n,1) cells.*/
+	{
+		cout << endl << "Broadcasting" << endl;
+		TN_Array<double> a(n,n,n), c(n,n,n), profile(1,1,n), surface(n,n,1);
+		TN_Array<double> fullprofile(n,n,n), fullsurface(n,n,n);
+		a.setrandom(0,1); profile.setrandom(0,1); surface.setrandom(0,1);
+		for(TN_Index i=0; i < n; ++i)
+			for(TN_Index j=0; j < n; ++j)
+				for(TN_Index k=0; k < n; ++k){
+					fullprofile(i,j,k) = profile(0,0,k);
+					fullsurface(i,j,k) = surface(i,j,0);
+				}
+		double texpanded = besttime([&](){
+			c = a + fullprofile*fullsurface;
+		});
+		double tbroadcast = besttime([&](){
+			c = a + profile.broadcast(n,n,n)*surface.broadcast(n,n,n);
+		});
+		cout << "  expanded arrays        : " << texpanded*1e3 << " ms, " << 2*n*n*n*sizeof(double)/1048576.0 << " MB extra" << endl;
+		cout << "  broadcast views        : " << tbroadcast*1e3 << " ms, " << n*(n+1)*sizeof(double)/1048576.0 << " MB extra" << endl;
+	}
+
+	//***********************
+	//  Matrix inverse and solve
+	//***********************
+
+	/*Per-cell inverse, determinant and solve of independent small matrices, serially, in ns per
+	matrix: 3x3 and 4x4 by their closed forms, 6x6 through LU factorisation. The cofactor
+	expansion LU replaced took about 28 us per 6x6 inverse.*/
+	{
+		cout << endl << "Matrix inverse and solve" << endl;
+		TN_Index ncells = n*n*16;
+		//ncells diagonally dominant matrices of A's size, each slightly different
+		auto matrices = [&](auto A){
+			int size = A.get_nrows();
+			for(int r=0; r < size; ++r)
+				for(int c=0; c < size; ++c)
+					A(r,c) = (r == c) ? 4.0 : 1.0/(1 + r + c);
+			vector<decltype(A)> m(ncells, A);
+			for(TN_Index c=0; c < ncells; ++c)
+				m[c](0,0) += 1e-6*c;
+			return m;
+		};
+		auto tinverse = [&](auto A){
+			auto in = matrices(A), out = in;
+			return besttime([&](){
+				for(TN_Index c=0; c < ncells; ++c)
+					out[c] = inverse(in[c]);
+			}, 3)/ncells;
+		};
+		auto in6 = matrices(TN_Matrix<double,6,6>());
+		vector<double> det6(ncells);
+		vector<TN_Matrix<double,6,1> > x6(ncells);
+		TN_Matrix<double,6,1> b6;
+		b6.set(0, 1, 2, 3, 4, 5);
+		double tdet6 = besttime([&](){
+			for(TN_Index c=0; c < ncells; ++c)
+				det6[c] = determinant(in6[c]);
+		}, 3)/ncells;
+		double tsolve6 = besttime([&](){
+			for(TN_Index c=0; c < ncells; ++c)
+				x6[c] = solve(in6[c], b6);
+		}, 3)/ncells;
+		cout << "  inverse 3x3            : " << tinverse(TN_Matrix<double,3,3>())*1e9 << " ns" << endl;
+		cout << "  inverse 4x4            : " << tinverse(TN_Matrix<double,4,4>())*1e9 << " ns" << endl;
+		cout << "  inverse 6x6            : " << tinverse(TN_Matrix<double,6,6>())*1e9 << " ns" << endl;
+		cout << "  determinant 6x6        : " << tdet6*1e9 << " ns" << endl;
+		cout << "  solve 6x6              : " << tsolve6*1e9 << " ns" << endl;
+	}
+
+	//***********************
+	//  Batched inverse and solve
+	//***********************
+
+	/*The inverse of every cell of arrays of 3x3 and 6x6 matrices, e.g. stiffnesses to compliances,
+	by a loop calling inverse() per cell and by the batched inverse(), in ns per cell.*/
+	{
+		cout << endl << "Batched inverse and solve" << endl;
+		auto tbatched = [&](auto A){
+			typedef decltype(A) matrix;
+			int size = A.get_nrows();
+			TN_Array<matrix> in(n,n,n), out(n,n,n);
+			TN_Array<double> singular(n,n,n);
+			for(TN_Index c=0; c < in.get_nt(); ++c){
+				for(int r=0; r < size; ++r)
+					for(int k=0; k < size; ++k)
+						A(r,k) = (r == k) ? 4.0 : 1.0/(1 + r + k) + 1e-9*c;
+				in(c) = A;
+			}
+			double tloop = besttime([&](){
+				#pragma omp parallel for schedule(static)
+				for(TN_Index c=0; c < in.get_nt(); ++c){
+					matrix a = in(c);
+					out(c) = inverse(a);
+				}
+			}, 3);
+			double tbatch = besttime([&](){
+				inverse(in, out, singular);
+			}, 3);
+			cout << "  inverse " << size << "x" << size << " per cell   : " << tloop/in.get_nt()*1e9 << " ns" << endl;
+			cout << "  inverse " << size << "x" << size << " batched    : " << tbatch/in.get_nt()*1e9 << " ns" << endl;
+		};
+		tbatched(TN_Matrix<double,3,3>());
+		tbatched(TN_Matrix<double,6,6>());
+	}
+
+	//***********************
+	//  Symmetric solves
+	//***********************
+
+	/*A 6x6 positive-definite stiffness solved against a stress, by LU, Cholesky and LDL^T, for
+	single matrices in ns per matrix and batched over an array in ns per cell.*/
+	{
+		cout << endl << "Symmetric solves" << endl;
+		TN_Matrix<double,6,6> C;
+		TN_Matrix<double,6,1> s;
+		for(int r=0; r < 6; ++r)
+			for(int k=0; k < 6; ++k)
+				C(r,k) = (r == k) ? 4.0 : 1.0/(1 + r + k);
+		s.set(0, 1, 2, 3, 4, 5);
+		TN_Index nsolves = n*n*16;
+		vector<TN_Matrix<double,6,6> > in(nsolves, C);
+		vector<TN_Matrix<double,6,1> > out(nsolves);
+		for(TN_Index c=0; c < nsolves; ++c)
+			in[c](0,0) += 1e-6*c;
+		double tlu = besttime([&](){
+			for(TN_Index c=0; c < nsolves; ++c)
+				out[c] = solve(in[c], s);
+		}, 3)/nsolves;
+		double tcholesky = besttime([&](){
+			for(TN_Index c=0; c < nsolves; ++c)
+				out[c] = solvecholesky(in[c], s);
+		}, 3)/nsolves;
+		double tldlt = besttime([&](){
+			for(TN_Index c=0; c < nsolves; ++c)
+				out[c] = solveldlt(in[c], s);
+		}, 3)/nsolves;
+		cout << "  solve 6x6 LU           : " << tlu*1e9 << " ns" << endl;
+		cout << "  solve 6x6 Cholesky     : " << tcholesky*1e9 << " ns" << endl;
+		cout << "  solve 6x6 LDL^T        : " << tldlt*1e9 << " ns" << endl;
+
+		TN_Array<TN_Matrix<double,6,6> > stiffness(n,n,n);
+		TN_Array<TN_Matrix<double,6,1> > stress(n,n,n), strain(n,n,n);
+		TN_Array<double> failed(n,n,n);
+		stiffness = C;
+		stress = s;
+		double tbatchlu = besttime([&](){
+			solve(stiffness, stress, strain, failed);
+		}, 3)/stiffness.get_nt();
+		double tbatchcholesky = besttime([&](){
+			solvecholesky(stiffness, stress, strain, failed);
+		}, 3)/stiffness.get_nt();
+		cout << "  batched 6x6 LU         : " << tbatchlu*1e9 << " ns" << endl;
+		cout << "  batched 6x6 Cholesky   : " << tbatchcholesky*1e9 << " ns" << endl;
+	}
+
+	//***********************
+	//  Symmetric eigen-decomposition
+	//***********************
+
+	/*The eigenvalues and eigenvectors of every cell of arrays of symmetric 3x3 and 6x6 matrices,
+	e.g. stresses and stiffnesses, by a loop calling eigensymmetric() per cell and by the batched
+	eigensymmetric(), in ns per cell.*/
+	{
+		cout << endl << "Symmetric eigen-decomposition" << endl;
+		auto teigen = [&](auto A, auto d){
+			typedef decltype(A) matrix;
+			typedef decltype(d) column;
+			int size = A.get_nrows();
+			TN_Array<matrix> in(n,n,n), vectors(n,n,n);
+			TN_Array<column> values(n,n,n);
+			for(TN_Index c=0; c < in.get_nt(); ++c){
+				for(int r=0; r < size; ++r)
+					for(int k=0; k < size; ++k)
+						A(r,k) = (r == k) ? 4.0 + 1e-6*c : 1.0/(1 + r + k);
+				in(c) = A;
+			}
+			double tloop = besttime([&](){
+				#pragma omp parallel for schedule(static)
+				for(TN_Index c=0; c < in.get_nt(); ++c){
+					matrix a = in(c), v;
+					column w;
+					eigensymmetric(a, w, v);
+					values(c) = w;
+					vectors(c) = v;
+				}
+			}, 3);
+			double tbatch = besttime([&](){
+				eigensymmetric(in, values, vectors);
+			}, 3);
+			cout << "  eigen " << size << "x" << size << " per cell     : " << tloop/in.get_nt()*1e9 << " ns" << endl;
+			cout << "  eigen " << size << "x" << size << " batched      : " << tbatch/in.get_nt()*1e9 << " ns" << endl;
+		};
+		teigen(TN_Matrix<double,3,3>(), TN_Matrix<double,3,1>());
+		teigen(TN_Matrix<double,6,6>(), TN_Matrix<double,6,1>());
+	}
+
+	cout << endl << "all done!" << endl;
+	return (0);
+}
@@ -6,7 +6,6 @@ TUNGSTEN Arrays of matrices
 
 #include <iostream>
 
-//#define TN_NOARRAYSOFMATRICES
 #define TN_PARALLELARRAY
 //#define TN_PARALLELMATRIX
 #define TN_INITIALIZE
@@ -41,9 +40,7 @@ int main(void)
 	/*Matrices can be used in typical arithmetic operations such as add, subtract, divide,
 	and multiply. Expressions can be written intuitively and are deliberately made to reflect
 	the mathematical expressions they represent, bridging the divide between math and code.
-	If compiled with
-	#define TN_NOARRAYSOFMATRICES
-	many of these expressions will be evaluated without the creation of temporaries.
+	Expressions are evaluated without the creation of temporaries.
 	An example expression could look like:
 	*/
 	mat6 = ((mat1 + 7.9) * mat4) - ((mat2 * 2.8 ) * (3.3 + mat5));
@@ -90,6 +87,16 @@ int main(void)
 	arr1 = (arr1 * 3.76) * (arr2 + 4.13) / arr3;
 	cout << "arr1 = " << arr1 << endl;
 
+	/*Parts of an array can be read or written in place through views, without copying. A view
+	takes a range of cells, optionally strided, along each axis, and slicex(i), slicey(j) and
+	slicez(k) give single planes. Views may be used wherever arrays of the same size may, and
+	assigning to a view only touches the cells it covers:	*/
+	TN_Array<double> arr4(4,3,1);
+	arr4 = 0.0;
+	arr4.view(TN_Range(0,4,2), TN_Range(0,3), TN_Range(0,1)) = arr2 * 2.0;
+	arr4.slicex(1) = arr4.slicex(0) + 1.0;
+	cout << "arr4 = " << arr4 << endl;
+
 	//***********************
 	//  Arrays of Matrices
 	//***********************